@@ -0,0 +1,58 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_BENCHMARK_ALLOCATIONS_HPP_INCLUDED
+#define STANDARDESE_BENCHMARK_ALLOCATIONS_HPP_INCLUDED
+
+// replaces the global operator new and delete to count the allocations of the program,
+// so it must only be included in the file with main()
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace standardese_benchmark
+{
+    namespace detail
+    {
+        std::atomic<std::size_t> allocation_count(0u);
+    } // namespace detail
+
+    // returns the number of allocations of all threads since the start of the program
+    inline std::size_t get_allocation_count() noexcept
+    {
+        return detail::allocation_count.load(std::memory_order_relaxed);
+    }
+
+    // returns the number of allocations during the execution of f
+    template <typename Func>
+    std::size_t count_allocations(Func f)
+    {
+        auto before = get_allocation_count();
+        f();
+        return get_allocation_count() - before;
+    }
+} // namespace standardese_benchmark
+
+void* operator new(std::size_t size)
+{
+    standardese_benchmark::detail::allocation_count.fetch_add(1u, std::memory_order_relaxed);
+    if (auto ptr = std::malloc(size == 0u ? 1u : size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+#if defined(__cpp_sized_deallocation)
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+#endif
+
+#endif // STANDARDESE_BENCHMARK_ALLOCATIONS_HPP_INCLUDED
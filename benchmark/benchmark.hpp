@@ -0,0 +1,148 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_BENCHMARK_HPP_INCLUDED
+#define STANDARDESE_BENCHMARK_HPP_INCLUDED
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace standardese_benchmark
+{
+    // returns the time it took to execute f in seconds
+    template <typename Func>
+    double measure(Func f)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end - begin).count();
+    }
+
+    struct iteration_options
+    {
+        unsigned warmup, iterations;
+    };
+
+    struct statistics
+    {
+        double median, p95, min; // in seconds
+    };
+
+    // executes f for the warmup without measuring it, then measures each iteration
+    // f(iteration) is called with the index of the iteration, starting with the warmup
+    template <typename Func>
+    statistics measure_statistics(const iteration_options& options, Func f)
+    {
+        auto iteration = 0u;
+        for (; iteration != options.warmup; ++iteration)
+            f(iteration);
+
+        std::vector<double> samples;
+        for (auto i = 0u; i != std::max(options.iterations, 1u); ++i, ++iteration)
+            samples.push_back(measure([&] { f(iteration); }));
+
+        std::sort(samples.begin(), samples.end());
+        return {samples[samples.size() / 2u], samples[(samples.size() * 95u - 1u) / 100u],
+                samples.front()};
+    }
+
+    // executes f(thread_index) on the given number of threads and returns the time in seconds
+    template <typename Func>
+    double measure_parallel(unsigned no_threads, Func f)
+    {
+        return measure([&] {
+            std::vector<std::thread> threads;
+            for (auto i = 0u; i != no_threads; ++i)
+                threads.emplace_back(f, i);
+            for (auto& thread : threads)
+                thread.join();
+        });
+    }
+
+    // returns the numeric command line argument at the given index or the default value
+    inline unsigned get_argument(int argc, char* argv[], int index, unsigned default_value)
+    {
+        if (index < argc)
+            return static_cast<unsigned>(std::strtoul(argv[index], nullptr, 10));
+        return default_value;
+    }
+
+    // returns the numeric value of a name=value command line argument or the default value
+    inline unsigned get_option(int argc, char* argv[], const std::string& name,
+                               unsigned default_value)
+    {
+        for (auto i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg.size() > name.size() && arg.compare(0, name.size(), name) == 0
+                && arg[name.size()] == '=')
+                return static_cast<unsigned>(
+                    std::strtoul(arg.c_str() + name.size() + 1u, nullptr, 10));
+        }
+        return default_value;
+    }
+
+    // returns the values of a name=a,b,c command line argument or the default values
+    inline std::vector<unsigned> get_option_list(int argc, char* argv[], const std::string& name,
+                                                 std::vector<unsigned> default_values)
+    {
+        for (auto i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg.size() > name.size() && arg.compare(0, name.size(), name) == 0
+                && arg[name.size()] == '=')
+            {
+                std::vector<unsigned> result;
+                for (auto cur = arg.c_str() + name.size() + 1u; *cur;)
+                {
+                    char* end;
+                    result.push_back(static_cast<unsigned>(std::strtoul(cur, &end, 10)));
+                    cur = *end == ',' ? end + 1 : end;
+                    if (*end != ',' && *end != '\0')
+                        break;
+                }
+                return result;
+            }
+        }
+        return default_values;
+    }
+
+    inline unsigned default_thread_count()
+    {
+        auto result = std::thread::hardware_concurrency();
+        return result == 0u ? 1u : result;
+    }
+
+    // reads the warmup=3 and iterations=20 options of a micro-benchmark
+    inline iteration_options get_iteration_options(int argc, char* argv[])
+    {
+        return {get_option(argc, argv, "warmup", 3u), get_option(argc, argv, "iterations", 20u)};
+    }
+
+    inline void print_result(const std::string& name, double seconds, std::size_t operations)
+    {
+        std::cout << name << ": " << seconds * 1000. << "ms";
+        if (operations != 0u)
+            std::cout << " (" << static_cast<std::size_t>(operations / seconds) << " op/s)";
+        std::cout << '\n';
+    }
+
+    // operations are per iteration, the throughput is based on the median
+    inline void print_result(const std::string& name, const statistics& s, std::size_t operations)
+    {
+        std::cout << name << ": median " << s.median * 1000. << "ms, p95 " << s.p95 * 1000.
+                  << "ms, min " << s.min * 1000. << "ms";
+        if (operations != 0u)
+            std::cout << " (" << static_cast<std::size_t>(operations / s.median) << " op/s)";
+        std::cout << '\n';
+    }
+} // namespace standardese_benchmark
+
+#endif // STANDARDESE_BENCHMARK_HPP_INCLUDED
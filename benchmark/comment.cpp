@@ -0,0 +1,47 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// measures reading the comments of a file and parsing them
+// usage: standardese_benchmark_comment [entities=3000] [comment_lines=16]
+//                                     [warmup=3] [iterations=20]
+
+#include <spdlog/spdlog.h>
+
+#include <standardese/detail/raw_comment.hpp>
+#include <standardese/comment.hpp>
+#include <standardese/parser.hpp>
+
+#include "benchmark.hpp"
+#include "corpus.hpp"
+
+using namespace standardese;
+namespace bm = standardese_benchmark;
+
+int main(int argc, char* argv[])
+{
+    auto options = bm::get_iteration_options(argc, argv);
+
+    bm::corpus_config config;
+    config.no_entities     = bm::get_option(argc, argv, "entities", 3000u);
+    config.comment_lines   = bm::get_option(argc, argv, "comment_lines", 16u);
+    config.comment_percent = 100u;
+
+    bm::corpus_statistics stats;
+    auto                  source = bm::generate_source(config, &stats);
+    std::cout << stats.no_comments << " comment(s), " << source.size() << " bytes\n";
+
+    std::size_t no_comments = 0u;
+    auto        read_time   = bm::measure_statistics(options, [&](unsigned) {
+        no_comments = detail::read_comments(source).size();
+    });
+    bm::print_result("read_comments (bytes)", read_time, source.size());
+    std::cout << no_comments << " comment(s) read\n";
+
+    // every iteration uses a different file name, so the comments are registered again
+    parser p(spdlog::stderr_logger_mt("benchmark"));
+    auto   parse_time = bm::measure_statistics(options, [&](unsigned iteration) {
+        parse_comments(p, ("file" + std::to_string(iteration)).c_str(), source);
+    });
+    bm::print_result("parse_comments (comments)", parse_time, stats.no_comments);
+}
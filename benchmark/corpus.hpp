@@ -0,0 +1,216 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_BENCHMARK_CORPUS_HPP_INCLUDED
+#define STANDARDESE_BENCHMARK_CORPUS_HPP_INCLUDED
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "benchmark.hpp"
+
+namespace standardese_benchmark
+{
+    // the shape of a synthetic project
+    struct corpus_config
+    {
+        unsigned no_headers      = 64u; // number of header files
+        unsigned no_entities     = 32u; // classes, functions and templates per header
+        unsigned comment_percent = 50u; // percentage of entities with a documentation comment
+        unsigned comment_lines   = 4u;  // lines of each documentation comment
+        unsigned no_includes     = 4u;  // number of other headers each header includes
+        unsigned no_macros       = 8u;  // number of macros per header
+        unsigned seed            = 42u; // the same seed always generates the same corpus
+    };
+
+    // reads the configuration from name=value command line arguments
+    inline corpus_config get_corpus_config(int argc, char* argv[])
+    {
+        corpus_config result;
+        result.no_headers      = get_option(argc, argv, "headers", result.no_headers);
+        result.no_entities     = get_option(argc, argv, "entities", result.no_entities);
+        result.comment_percent = get_option(argc, argv, "comments", result.comment_percent);
+        result.comment_lines   = get_option(argc, argv, "comment_lines", result.comment_lines);
+        result.no_includes     = get_option(argc, argv, "includes", result.no_includes);
+        result.no_macros       = get_option(argc, argv, "macros", result.no_macros);
+        result.seed            = get_option(argc, argv, "seed", result.seed);
+        return result;
+    }
+
+    struct corpus_statistics
+    {
+        std::size_t no_files    = 0u;
+        std::size_t no_entities = 0u; // including members and macros
+        std::size_t no_comments = 0u;
+        std::size_t no_bytes    = 0u;
+    };
+
+    namespace detail
+    {
+        class corpus_writer
+        {
+        public:
+            corpus_writer(const corpus_config& config, corpus_statistics& stats)
+            : config_(config), stats_(stats), random_(config.seed), index_(0u)
+            {
+            }
+
+            void write_header(std::ostream& out, unsigned index)
+            {
+                index_     = index;
+                auto guard = "CORPUS_HEADER_" + std::to_string(index) + "_HPP_INCLUDED";
+                out << "// generated by standardese_generate_corpus\n\n";
+                out << "#ifndef " << guard << "\n#define " << guard << "\n\n";
+
+                // only earlier headers are included, so there are no include cycles
+                for (auto included : get_includes(index))
+                    out << "#include \"header_" << included << ".hpp\"\n";
+                out << '\n';
+
+                for (auto i = 0u; i != config_.no_macros; ++i)
+                {
+                    write_comment(out, "", "A macro.");
+                    out << "#define CORPUS_H" << index << "_MACRO" << i << "(x) ((x) * " << i
+                        << ")\n\n";
+                    ++stats_.no_entities;
+                }
+
+                out << "namespace corpus\n{\nnamespace h" << index << "\n{\n";
+                for (auto i = 0u; i != config_.no_entities; ++i)
+                {
+                    switch (i % 3u)
+                    {
+                    case 0u:
+                        write_class(out, i);
+                        break;
+                    case 1u:
+                        write_function(out, i);
+                        break;
+                    case 2u:
+                        write_template(out, i);
+                        break;
+                    }
+                    out << '\n';
+                }
+                out << "} // namespace h" << index << "\n} // namespace corpus\n\n";
+                out << "#endif // " << guard << '\n';
+            }
+
+        private:
+            // distinct headers before the given one
+            std::vector<unsigned> get_includes(unsigned index)
+            {
+                std::vector<unsigned> result;
+                while (result.size() != std::min(config_.no_includes, index))
+                {
+                    std::uniform_int_distribution<unsigned> distribution(0u, index - 1u);
+                    auto                                    included = distribution(random_);
+                    if (std::find(result.begin(), result.end(), included) == result.end())
+                        result.push_back(included);
+                }
+                return result;
+            }
+
+            void write_comment(std::ostream& out, const char* indent, const char* brief)
+            {
+                if (std::uniform_int_distribution<unsigned>(0u, 99u)(random_)
+                    >= config_.comment_percent)
+                    return;
+
+                out << indent << "/// " << brief << '\n';
+                for (auto i = 1u; i < config_.comment_lines; ++i)
+                {
+                    if (i == 1u)
+                        out << indent << "///\n";
+                    else if (i + 1u == config_.comment_lines)
+                        // every header starts with class_0
+                        out << indent << "/// See also [corpus::h" << index_ << "::class_0]().\n";
+                    else
+                        out << indent << "/// This is a *longer* description of the entity,"
+                            << " so that the `comment` parser has something to do.\n";
+                }
+                ++stats_.no_comments;
+            }
+
+            void write_class(std::ostream& out, unsigned i)
+            {
+                write_comment(out, "", "A class.");
+                out << "class class_" << i << "\n{\npublic:\n";
+                write_comment(out, "    ", "A constructor.");
+                out << "    explicit class_" << i << "(int value);\n\n";
+                write_comment(out, "    ", "A member function.");
+                out << "    int get_value() const noexcept;\n\n";
+                write_comment(out, "    ", "Another member function.");
+                out << "    void set_value(int value);\n\n";
+                out << "private:\n    int value_;\n};\n";
+                stats_.no_entities += 5u;
+            }
+
+            void write_function(std::ostream& out, unsigned i)
+            {
+                write_comment(out, "", "A function.");
+                out << "int function_" << i << "(int a, const char* b, double c = 1.0);\n";
+                ++stats_.no_entities;
+            }
+
+            void write_template(std::ostream& out, unsigned i)
+            {
+                write_comment(out, "", "A function template.");
+                out << "template <typename T, int N = " << i << ">\n"
+                    << "T template_" << i << "(const T& value);\n";
+                ++stats_.no_entities;
+            }
+
+            const corpus_config& config_;
+            corpus_statistics&   stats_;
+            std::minstd_rand     random_;
+            unsigned             index_; // of the current header
+        };
+    } // namespace detail
+
+    // returns a single header without includes
+    inline std::string generate_source(const corpus_config& config,
+                                       corpus_statistics*   stats = nullptr)
+    {
+        corpus_statistics     tmp;
+        detail::corpus_writer writer(config, stats ? *stats : tmp);
+
+        std::ostringstream out;
+        writer.write_header(out, 0u);
+        return out.str();
+    }
+
+    // writes the headers header_0.hpp ... header_<n-1>.hpp into the directory,
+    // replacing the previous contents of the directory
+    inline corpus_statistics generate_corpus(const boost::filesystem::path& dir,
+                                             const corpus_config&           config)
+    {
+        boost::filesystem::remove_all(dir);
+        boost::filesystem::create_directories(dir);
+
+        corpus_statistics     stats;
+        detail::corpus_writer writer(config, stats);
+        for (auto i = 0u; i != config.no_headers; ++i)
+        {
+            auto          path = dir / ("header_" + std::to_string(i) + ".hpp");
+            std::ofstream out(path.string());
+            if (!out.is_open())
+                throw std::runtime_error("unable to write '" + path.string() + "'");
+            writer.write_header(out, i);
+            stats.no_bytes += std::size_t(out.tellp());
+            ++stats.no_files;
+        }
+        return stats;
+    }
+} // namespace standardese_benchmark
+
+#endif // STANDARDESE_BENCHMARK_CORPUS_HPP_INCLUDED
@@ -0,0 +1,116 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// measures allocating, traversing and freeing entity-sized nodes in an entity_arena and on the heap
+// it doesn't need libclang, the strings allocated in between mimic the names and comments
+// the parser allocates while it creates the entities
+// usage: standardese_benchmark_entity_arena [entities=200000] [warmup=3] [iterations=20]
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <standardese/detail/entity_arena.hpp>
+
+#include "allocations.hpp"
+#include "benchmark.hpp"
+
+using namespace standardese;
+namespace bm = standardese_benchmark;
+
+namespace
+{
+    // roughly the size of a cpp_entity
+    struct node
+    {
+        node*       next;
+        std::size_t value;
+        char        payload[112];
+    };
+
+    struct list
+    {
+        std::unique_ptr<detail::entity_arena> arena;
+        std::vector<std::string>              strings;
+        node*                                 head;
+    };
+
+    list build(std::size_t no_entities, bool use_arena)
+    {
+        list result;
+        result.arena.reset(use_arena ? new detail::entity_arena : nullptr);
+        result.strings.reserve(no_entities);
+        result.head = nullptr;
+
+        auto tail = &result.head;
+        for (auto i = 0u; i != no_entities; ++i)
+        {
+            auto n   = static_cast<node*>(detail::allocate_entity(result.arena.get(), sizeof(node)));
+            n->next  = nullptr;
+            n->value = i;
+            *tail    = n;
+            tail     = &n->next;
+
+            result.strings.emplace_back(32u + i % 64u, 'a');
+        }
+        return result;
+    }
+
+    std::size_t traverse(const list& l)
+    {
+        std::size_t result = 0u;
+        for (auto cur = l.head; cur; cur = cur->next)
+            result += cur->value;
+        return result;
+    }
+
+    void destroy(list& l)
+    {
+        for (auto cur = l.head; cur;)
+        {
+            auto next = cur->next;
+            detail::deallocate_entity(cur);
+            cur = next;
+        }
+        l.head = nullptr;
+        l.strings.clear();
+        l.arena.reset();
+    }
+
+    void run(const bm::iteration_options& options, std::size_t no_entities, bool use_arena)
+    {
+        auto name = std::string(use_arena ? "arena" : "heap");
+
+        std::vector<list> lists;
+        std::size_t       no_allocations = 0u;
+        auto              build_time     = bm::measure_statistics(options, [&](unsigned) {
+            no_allocations = bm::count_allocations([&] {
+                lists.push_back(build(no_entities, use_arena));
+            });
+        });
+        std::cout << name << ": " << no_allocations << " allocation(s) per build\n";
+        bm::print_result(name + " build", build_time, no_entities);
+
+        volatile std::size_t sum = 0u; // keeps the traversal
+        auto                 traverse_time =
+            bm::measure_statistics(options, [&](unsigned) { sum = traverse(lists.back()); });
+        bm::print_result(name + " traverse", traverse_time, no_entities);
+
+        auto no_lists     = lists.size();
+        auto destroy_time = bm::measure([&] {
+            for (auto& l : lists)
+                destroy(l);
+        });
+        bm::print_result(name + " destroy", destroy_time / no_lists, no_entities);
+    }
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    auto options     = bm::get_iteration_options(argc, argv);
+    auto no_entities = bm::get_option(argc, argv, "entities", 200000u);
+
+    run(options, no_entities, false);
+    run(options, no_entities, true);
+}
@@ -0,0 +1,74 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// measures registration and concurrent lookup in the cpp_entity_registry
+// usage: standardese_benchmark_entity_registry [entities=100000] [threads=hardware]
+
+#include <fstream>
+
+#include <spdlog/spdlog.h>
+
+#include <standardese/cpp_entity_registry.hpp>
+#include <standardese/cpp_namespace.hpp>
+#include <standardese/parser.hpp>
+#include <standardese/translation_unit.hpp>
+
+#include "allocations.hpp"
+#include "benchmark.hpp"
+
+using namespace standardese;
+namespace bm = standardese_benchmark;
+
+int main(int argc, char* argv[])
+{
+    auto no_entities = bm::get_argument(argc, argv, 1, 100000u);
+    auto no_threads  = bm::get_argument(argc, argv, 2, bm::default_thread_count());
+    auto no_rounds   = 4u;
+
+    auto file_name = "standardese_benchmark_entity_registry.cpp";
+    {
+        std::ofstream file(file_name);
+        for (auto i = 0u; i != no_entities; ++i)
+            file << "namespace ns" << i % 64 << " { struct entity" << i << " {}; }\n";
+    }
+
+    parser         p(spdlog::stderr_logger_mt("benchmark"));
+    compile_config config(cpp_standard::cpp_11);
+    config.set_preprocessor_backend(preprocessor_backend::in_process);
+
+    std::vector<translation_unit> tus;
+    auto parse_time = bm::measure([&] { tus.push_back(p.parse(file_name, config)); });
+    bm::print_result("parse", parse_time, 0u);
+
+    // the top-level entities are namespaces, collect their children
+    auto&                          file = tus.front().get_file();
+    std::vector<const cpp_entity*> entities;
+    for (auto& ns : file)
+        if (ns.get_entity_type() == cpp_entity::namespace_t)
+            for (auto& e : static_cast<const cpp_namespace&>(ns))
+                entities.push_back(&e);
+    std::cout << entities.size() << " entities, " << no_threads << " thread(s)\n";
+
+    cpp_entity_registry registry;
+    auto                no_allocations = bm::get_allocation_count();
+    auto                register_time  = bm::measure([&] {
+        for (auto e : entities)
+            registry.register_entity(*e);
+    });
+    no_allocations = bm::get_allocation_count() - no_allocations;
+    bm::print_result("register", register_time, entities.size());
+    std::cout << no_allocations << " allocation(s)\n";
+
+    auto lookup_time = bm::measure_parallel(no_threads, [&](unsigned thread) {
+        for (auto round = 0u; round != no_rounds; ++round)
+            // start at different positions, so that the threads don't access the same entities
+            for (auto i = 0u; i != entities.size(); ++i)
+            {
+                auto& e = *entities[(i + thread * entities.size() / no_threads) % entities.size()];
+                if (registry.try_lookup(e.get_cursor()) != &e)
+                    std::abort();
+            }
+    });
+    bm::print_result("lookup", lookup_time, std::size_t(no_rounds) * no_threads * entities.size());
+}
@@ -0,0 +1,106 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// measures building, traversing and destroying the entity trees of a large header
+// the traversals only chase pointers, run it with `perf stat -e cache-misses,cache-references`
+// to count their cache misses
+// usage: standardese_benchmark_entity_tree [entities=20000] [warmup=3] [iterations=20]
+
+#include <fstream>
+
+#include <spdlog/spdlog.h>
+
+#include <standardese/cpp_class.hpp>
+#include <standardese/cpp_namespace.hpp>
+#include <standardese/doc_entity.hpp>
+#include <standardese/index.hpp>
+#include <standardese/parser.hpp>
+#include <standardese/translation_unit.hpp>
+
+#include "benchmark.hpp"
+#include "corpus.hpp"
+
+using namespace standardese;
+namespace bm = standardese_benchmark;
+
+namespace
+{
+    template <class Container>
+    std::size_t visit_children(const Container& container);
+
+    std::size_t visit(const cpp_entity& e)
+    {
+        if (e.get_entity_type() == cpp_entity::namespace_t)
+            return 1u + visit_children(static_cast<const cpp_namespace&>(e));
+        else if (e.get_entity_type() == cpp_entity::class_t)
+            return 1u + visit_children(static_cast<const cpp_class&>(e));
+        return 1u;
+    }
+
+    template <class Container>
+    std::size_t visit_children(const Container& container)
+    {
+        std::size_t result = 0u;
+        for (auto& child : container)
+            result += visit(child);
+        return result;
+    }
+
+    std::size_t visit(const doc_entity& e)
+    {
+        std::size_t result = 1u;
+        for (auto& child : e)
+            result += visit(child);
+        return result;
+    }
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    auto options = bm::get_iteration_options(argc, argv);
+
+    bm::corpus_config config;
+    config.no_entities     = bm::get_option(argc, argv, "entities", 20000u);
+    config.comment_percent = 100u; // only documented entities get a doc_entity
+
+    auto file_name = "standardese_benchmark_entity_tree.hpp";
+    {
+        std::ofstream file(file_name);
+        file << bm::generate_source(config);
+    }
+
+    parser         p(spdlog::stderr_logger_mt("benchmark"));
+    compile_config compile(cpp_standard::cpp_11);
+    compile.set_preprocessor_backend(preprocessor_backend::in_process);
+
+    std::vector<translation_unit> tus;
+    auto parse_time = bm::measure([&] { tus.push_back(p.parse(file_name, compile)); });
+    bm::print_result("parse (including libclang)", parse_time, 0u);
+    auto& file = tus.front().get_file();
+
+    std::size_t no_cpp_entities = 0u;
+    auto        cpp_time        = bm::measure_statistics(options, [&](unsigned) {
+        no_cpp_entities = visit_children(file);
+    });
+    bm::print_result("traverse cpp_entity", cpp_time, no_cpp_entities);
+
+    // every iteration needs its own index, as the entities are registered in it
+    std::vector<standardese::index> indices(options.warmup + std::max(options.iterations, 1u));
+    std::vector<doc_ptr<doc_file>>  files;
+
+    auto build_time = bm::measure_statistics(options, [&](unsigned iteration) {
+        files.push_back(doc_file::parse(p, indices[iteration], "entity_tree", file));
+    });
+
+    std::size_t no_doc_entities = 0u;
+    auto        doc_time        = bm::measure_statistics(options, [&](unsigned) {
+        no_doc_entities = visit(*files.back());
+    });
+    bm::print_result("doc_file::parse", build_time, no_doc_entities);
+    bm::print_result("traverse doc_entity", doc_time, no_doc_entities);
+
+    auto no_files     = files.size();
+    auto destroy_time = bm::measure([&] { files.clear(); });
+    bm::print_result("destroy doc_file", destroy_time / no_files, no_doc_entities);
+}
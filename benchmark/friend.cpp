@@ -0,0 +1,96 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// measures rewriting the friend definitions of a header with thousands of friend operators
+// and parsing it
+// usage: standardese_benchmark_friend [classes=2000] [warmup=3] [iterations=20]
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include <spdlog/spdlog.h>
+
+#include <standardese/detail/friend_rewriter.hpp>
+#include <standardese/parser.hpp>
+#include <standardese/translation_unit.hpp>
+
+#include "benchmark.hpp"
+
+using namespace standardese;
+namespace bm = standardese_benchmark;
+
+namespace
+{
+    // each class has three friend operator definitions and one declaration
+    std::string generate_source(unsigned no_classes)
+    {
+        std::ostringstream out;
+        for (auto i = 0u; i != no_classes; ++i)
+        {
+            auto name = "class_" + std::to_string(i);
+            out << "/// A class with operators.\n";
+            out << "class " << name << "\n{\npublic:\n";
+            out << "    explicit " << name << "(int value) : value_(value) {}\n\n";
+            out << "    /// Compares two objects, a friend isn't a member.\n";
+            out << "    friend bool operator==(const " << name << "& a, const " << name
+                << "& b) noexcept\n    {\n        return a.value_ == b.value_;\n    }\n\n";
+            out << "    friend bool operator!=(const " << name << "& a, const " << name
+                << "& b) noexcept\n    {\n        return !(a == b);\n    }\n\n";
+            out << "    friend bool operator<(const " << name << "& a, const " << name
+                << "& b) noexcept;\n\n";
+            out << "    friend " << name << " operator+(const " << name << "& a, const " << name
+                << "& b)\n    {\n        return " << name << "(a.value_ + b.value_);\n    }\n\n";
+            out << "private:\n    int value_;\n};\n\n";
+        }
+        return out.str();
+    }
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    auto options = bm::get_iteration_options(argc, argv);
+
+    auto source = generate_source(bm::get_option(argc, argv, "classes", 2000u));
+    std::cout << source.size() << " bytes\n";
+
+    // the preprocessor appends the source in runs, the rewriter scans them as they are appended
+    std::size_t no_definitions = 0u;
+    auto        append_time    = bm::measure_statistics(options, [&](unsigned) {
+        std::string             result;
+        detail::friend_rewriter rewriter(result);
+        for (auto begin = source.c_str(), end = begin + source.size(); begin != end;)
+        {
+            auto line_end = std::find(begin, end, '\n');
+            result.append(begin, line_end == end ? end : line_end + 1);
+            rewriter.rewrite();
+            begin = line_end == end ? end : line_end + 1;
+        }
+        rewriter.finish();
+        no_definitions = rewriter.get_definition_count();
+    });
+    bm::print_result("rewrite while appending lines (bytes)", append_time, source.size());
+    std::cout << no_definitions << " friend definition(s) rewritten\n";
+
+    // includes copying the source
+    auto complete_time = bm::measure_statistics(options, [&](unsigned) {
+        auto copy = source;
+        detail::rewrite_friend_definitions(copy);
+    });
+    bm::print_result("rewrite complete source (bytes)", complete_time, source.size());
+
+    auto file_name = "standardese_benchmark_friend.hpp";
+    {
+        std::ofstream file(file_name);
+        file << source;
+    }
+
+    parser         p(spdlog::stderr_logger_mt("benchmark"));
+    compile_config compile(cpp_standard::cpp_11);
+    compile.set_preprocessor_backend(preprocessor_backend::in_process);
+
+    std::vector<translation_unit> tus;
+    auto parse_time = bm::measure([&] { tus.push_back(p.parse(file_name, compile)); });
+    bm::print_result("parse (including libclang)", parse_time, 0u);
+}
@@ -0,0 +1,26 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// writes a synthetic project into a directory, e.g. to profile the tool on it
+// usage: standardese_generate_corpus <directory> [headers=64] [entities=32] [comments=50]
+//                                                [includes=4] [macros=8] [seed=42]
+
+#include <iostream>
+
+#include "corpus.hpp"
+
+namespace bm = standardese_benchmark;
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || std::string(argv[1]).find('=') != std::string::npos)
+    {
+        std::cerr << "usage: " << argv[0] << " <directory> [name=value...]\n";
+        return 1;
+    }
+
+    auto stats = bm::generate_corpus(argv[1], bm::get_corpus_config(argc, argv));
+    std::cout << stats.no_files << " file(s), " << stats.no_entities << " entities, "
+              << stats.no_comments << " comment(s), " << stats.no_bytes << " bytes\n";
+}
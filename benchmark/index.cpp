@@ -0,0 +1,99 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// measures registration and name lookup in the index and URL generation of the linker
+// usage: standardese_benchmark_index [entities=3000] [warmup=3] [iterations=20]
+
+#include <fstream>
+
+#include <spdlog/spdlog.h>
+
+#include <standardese/doc_entity.hpp>
+#include <standardese/index.hpp>
+#include <standardese/linker.hpp>
+#include <standardese/parser.hpp>
+#include <standardese/translation_unit.hpp>
+
+#include "allocations.hpp"
+#include "benchmark.hpp"
+#include "corpus.hpp"
+
+using namespace standardese;
+namespace bm = standardese_benchmark;
+
+namespace
+{
+    void collect(std::vector<const doc_entity*>& result, const doc_entity& e)
+    {
+        if (e.get_entity_type() != doc_entity::member_group_t && !e.get_unique_name().empty())
+            result.push_back(&e);
+        for (auto& child : e)
+            collect(result, child);
+    }
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    auto options = bm::get_iteration_options(argc, argv);
+
+    bm::corpus_config config;
+    config.no_entities     = bm::get_option(argc, argv, "entities", 3000u);
+    config.comment_percent = 100u; // only documented entities are registered
+
+    auto file_name = "standardese_benchmark_index.hpp";
+    {
+        std::ofstream file(file_name);
+        file << bm::generate_source(config);
+    }
+
+    parser         p(spdlog::stderr_logger_mt("benchmark"));
+    compile_config compile(cpp_standard::cpp_11);
+    compile.set_preprocessor_backend(preprocessor_backend::in_process);
+    auto tu = p.parse(file_name, compile);
+
+    // the names of the entities are built and registered in the index while parsing them
+    standardese::index idx;
+    doc_ptr<doc_file>  file;
+    auto               no_allocations = bm::count_allocations([&] {
+        file = doc_file::parse(p, idx, "index", tu.get_file());
+        idx.freeze();
+    });
+    idx.get_linker().freeze();
+    std::cout << no_allocations << " allocation(s) for the documentation entities, "
+              << p.get_string_table().size() << " interned string(s)\n";
+
+    std::vector<const doc_entity*> entities;
+    collect(entities, *file);
+    std::vector<std::string> names;
+    for (auto e : entities)
+        names.push_back(e->get_unique_name().c_str());
+    std::cout << entities.size() << " entities\n";
+
+    // the names are looked up relative to each entity, like the links in its comment
+    std::size_t no_found    = 0u;
+    auto        lookup_time = bm::measure_statistics(options, [&](unsigned) {
+        no_found = 0u;
+        for (auto i = 0u; i != entities.size(); ++i)
+            if (idx.try_name_lookup(*entities[i], names[(i * 7u) % names.size()]))
+                ++no_found;
+    });
+    bm::print_result("index::try_name_lookup", lookup_time, entities.size());
+    std::cout << no_found << " of " << entities.size() << " name(s) found, "
+              << bm::count_allocations([&] {
+                     for (auto i = 0u; i != entities.size(); ++i)
+                         idx.try_name_lookup(*entities[i], names[(i * 7u) % names.size()]);
+                 })
+              << " allocation(s) per iteration\n";
+
+    std::size_t no_bytes = 0u;
+    auto        url_time = bm::measure_statistics(options, [&](unsigned) {
+        no_bytes = 0u;
+        for (auto i = 0u; i != names.size(); ++i)
+            no_bytes += idx.get_linker()
+                            .get_url(idx, p.get_external_linker(), entities[i], names[i], "md")
+                            .size();
+    });
+    bm::print_result("linker::get_url", url_time, names.size());
+    std::cout << no_bytes << " bytes of URLs\n";
+}
@@ -0,0 +1,76 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// measures writing to an output stream and resolving the entity links of a document
+// usage: standardese_benchmark_output [entities=3000] [kib=4096] [warmup=3] [iterations=20]
+
+#include <fstream>
+
+#include <spdlog/spdlog.h>
+
+#include <standardese/generator.hpp>
+#include <standardese/index.hpp>
+#include <standardese/md_custom.hpp>
+#include <standardese/output.hpp>
+#include <standardese/output_stream.hpp>
+#include <standardese/parser.hpp>
+#include <standardese/translation_unit.hpp>
+
+#include "benchmark.hpp"
+#include "corpus.hpp"
+
+using namespace standardese;
+namespace bm = standardese_benchmark;
+
+int main(int argc, char* argv[])
+{
+    auto options = bm::get_iteration_options(argc, argv);
+
+    // lines of different length, written with indentation like a code block
+    auto        no_bytes = std::size_t(bm::get_option(argc, argv, "kib", 4096u)) * 1024u;
+    std::string line     = "template <typename T, int N = 42> T template_42(const T& value);";
+    auto        write_time = bm::measure_statistics(options, [&](unsigned) {
+        string_output out;
+        out.indent(4u);
+        for (std::size_t written = 0u, i = 0u; written < no_bytes; ++i)
+        {
+            auto length = 16u + i % (line.size() - 16u);
+            out.write_str(line.c_str(), length);
+            out.write_char(';');
+            out.write_new_line();
+            written += length + 1u;
+        }
+    });
+    bm::print_result("output_stream_base (bytes)", write_time, no_bytes);
+
+    bm::corpus_config config;
+    config.no_entities     = bm::get_option(argc, argv, "entities", 3000u);
+    config.comment_percent = 100u;
+
+    auto file_name = "standardese_benchmark_output.hpp";
+    {
+        std::ofstream file(file_name);
+        file << bm::generate_source(config);
+    }
+
+    parser         p(spdlog::stderr_logger_mt("benchmark"));
+    compile_config compile(cpp_standard::cpp_11);
+    compile.set_preprocessor_backend(preprocessor_backend::in_process);
+    auto tu = p.parse(file_name, compile);
+
+    standardese::index idx;
+    auto               doc = generate_doc_file(p, idx, tu.get_file(), "output");
+    idx.freeze();
+    idx.get_linker().freeze();
+
+    // normalize_urls() modifies the document, so every iteration gets its own copy
+    std::vector<md_ptr<md_document>> documents;
+    for (auto i = 0u; i != options.warmup + options.iterations; ++i)
+        documents.emplace_back(static_cast<md_document*>(doc.document->clone().release()));
+
+    auto normalize_time = bm::measure_statistics(options, [&](unsigned iteration) {
+        normalize_urls(idx, *documents[iteration]);
+    });
+    bm::print_result("normalize_urls (documents)", normalize_time, 1u);
+}
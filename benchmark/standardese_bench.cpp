@@ -0,0 +1,114 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// measures the whole tool on a synthetic project with different numbers of threads
+// usage: standardese_bench [headers=64] [entities=32] [comments=50] [includes=4] [macros=8]
+//                          [seed=42] [jobs=1,2,4,...,hardware] [runs=3]
+// the best of the runs is reported for each number of threads,
+// a final verbose run reports the number of clang_tokenize() calls
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include "corpus.hpp"
+
+#ifndef STANDARDESE_TOOL
+#error "STANDARDESE_TOOL must be the path of the tool executable"
+#endif
+
+namespace bm = standardese_benchmark;
+
+namespace
+{
+    std::vector<unsigned> default_jobs()
+    {
+        std::vector<unsigned> result;
+        for (auto i = 1u; i < bm::default_thread_count(); i *= 2u)
+            result.push_back(i);
+        result.push_back(bm::default_thread_count());
+        return result;
+    }
+
+    std::string null_device()
+    {
+#if defined(_WIN32)
+        return "NUL";
+#else
+        return "/dev/null";
+#endif
+    }
+
+    // runs the tool and writes its output into the given log file
+    bool run_tool(unsigned no_threads, const std::string& corpus, const std::string& output,
+                  const std::string& log, bool verbose = false)
+    {
+        auto command = std::string("\"") + STANDARDESE_TOOL + "\" -j " + std::to_string(no_threads)
+                       + (verbose ? " -v" : "") + " --output.prefix=" + output + "/ " + corpus
+                       + " > " + log + " 2>&1";
+        return std::system(command.c_str()) == 0;
+    }
+
+    // returns the number of clang_tokenize() calls logged by a verbose run, or -1
+    long get_tokenize_count(const std::string& log)
+    {
+        std::ifstream file(log);
+        std::string   line;
+        while (std::getline(file, line))
+        {
+            auto pos = line.find("Tokenized ");
+            if (pos != std::string::npos)
+                return std::strtol(line.c_str() + pos + 10u, nullptr, 10);
+        }
+        return -1;
+    }
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    auto config  = bm::get_corpus_config(argc, argv);
+    auto jobs    = bm::get_option_list(argc, argv, "jobs", default_jobs());
+    auto no_runs = std::max(bm::get_option(argc, argv, "runs", 3u), 1u);
+
+    auto corpus = "standardese_bench_corpus";
+    auto output = "standardese_bench_output";
+    auto stats  = bm::generate_corpus(corpus, config);
+    std::cout << stats.no_files << " file(s), " << stats.no_entities << " entities, "
+              << stats.no_comments << " comment(s), " << stats.no_bytes << " bytes\n";
+
+    auto baseline = 0.0;
+    for (auto no_threads : jobs)
+    {
+        auto best = 0.0;
+        for (auto run = 0u; run != no_runs; ++run)
+        {
+            auto success = true;
+            auto seconds =
+                bm::measure([&] { success = run_tool(no_threads, corpus, output, null_device()); });
+            if (!success)
+            {
+                std::cerr << "error: the tool failed with -j " << no_threads << '\n';
+                return 1;
+            }
+            best = run == 0u ? seconds : std::min(best, seconds);
+        }
+        if (baseline == 0.0)
+            baseline = best;
+
+        std::cout << "-j " << no_threads << ": " << best * 1000. << "ms ("
+                  << static_cast<std::size_t>(stats.no_files / best) << " files/s, "
+                  << static_cast<std::size_t>(stats.no_entities / best) << " entities/s, "
+                  << baseline / best << "x)\n";
+    }
+
+    // not measured, the debug output would distort the times
+    auto log = "standardese_bench_output.log";
+    if (!run_tool(jobs.front(), corpus, output, log, true))
+    {
+        std::cerr << "error: the verbose run of the tool failed\n";
+        return 1;
+    }
+    std::cout << get_tokenize_count(log) << " call(s) of clang_tokenize()\n";
+}
@@ -0,0 +1,66 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// measures processing a template that loops over all entities of a file
+// usage: standardese_benchmark_template [entities=1000] [repeat=4] [warmup=3] [iterations=20]
+
+#include <fstream>
+
+#include <spdlog/spdlog.h>
+
+#include <standardese/doc_entity.hpp>
+#include <standardese/index.hpp>
+#include <standardese/parser.hpp>
+#include <standardese/template_processor.hpp>
+#include <standardese/translation_unit.hpp>
+
+#include "benchmark.hpp"
+#include "corpus.hpp"
+
+using namespace standardese;
+namespace bm = standardese_benchmark;
+
+int main(int argc, char* argv[])
+{
+    auto options = bm::get_iteration_options(argc, argv);
+
+    bm::corpus_config config;
+    config.no_entities     = bm::get_option(argc, argv, "entities", 1000u);
+    config.comment_percent = 100u;
+
+    auto file_name = "standardese_benchmark_template.hpp";
+    {
+        std::ofstream file(file_name);
+        file << bm::generate_source(config);
+    }
+
+    parser         p(spdlog::stderr_logger_mt("benchmark"));
+    compile_config compile(cpp_standard::cpp_11);
+    compile.set_preprocessor_backend(preprocessor_backend::in_process);
+    auto tu = p.parse(file_name, compile);
+
+    standardese::index idx;
+    auto               file = doc_file::parse(p, idx, "template", tu.get_file());
+    idx.freeze();
+
+    std::string code;
+    for (auto i = 0u; i != bm::get_option(argc, argv, "repeat", 4u); ++i)
+        code += R"(
+{{ standardese_for $entity corpus::h0 }}
+## {{ standardese_name $entity }}
+
+Unique name: {{ standardese_unique_name $entity }}
+
+{{ standardese_doc_text $entity commonmark }}
+{{ standardese_end }}
+)";
+    template_file input("template.md", code);
+
+    std::size_t no_bytes = 0u;
+    auto        time     = bm::measure_statistics(options, [&](unsigned) {
+        no_bytes = process_template(p, idx, input).text.size();
+    });
+    std::cout << code.size() << " bytes of template, " << no_bytes << " bytes generated\n";
+    bm::print_result("process_template (bytes)", time, no_bytes);
+}
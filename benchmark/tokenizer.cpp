@@ -0,0 +1,74 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+// measures tokenizing the entities of a file and reading the spelling of the tokens
+// usage: standardese_benchmark_tokenizer [entities=3000] [warmup=3] [iterations=20]
+
+#include <algorithm>
+#include <fstream>
+
+#include <spdlog/spdlog.h>
+
+#include <standardese/detail/tokenizer.hpp>
+#include <standardese/cpp_namespace.hpp>
+#include <standardese/parser.hpp>
+#include <standardese/translation_unit.hpp>
+
+#include "benchmark.hpp"
+#include "corpus.hpp"
+
+using namespace standardese;
+namespace bm = standardese_benchmark;
+
+int main(int argc, char* argv[])
+{
+    auto options = bm::get_iteration_options(argc, argv);
+
+    bm::corpus_config config;
+    config.no_entities = bm::get_option(argc, argv, "entities", 3000u);
+
+    auto file_name = "standardese_benchmark_tokenizer.hpp";
+    {
+        std::ofstream file(file_name);
+        file << bm::generate_source(config);
+    }
+
+    parser         p(spdlog::stderr_logger_mt("benchmark"));
+    compile_config compile(cpp_standard::cpp_11);
+    compile.set_preprocessor_backend(preprocessor_backend::in_process);
+    auto tu = p.parse(file_name, compile);
+
+    // the file is tokenized once, further calls are only necessary for ranges inside a token
+    auto parse_calls = detail::get_tokenize_count();
+    std::cout << parse_calls << " call(s) of clang_tokenize() while parsing\n";
+
+    // the entities are in namespace corpus::h0
+    std::vector<const cpp_entity*> entities;
+    for (auto& ns : tu.get_file())
+        if (ns.get_entity_type() == cpp_entity::namespace_t)
+            for (auto& inner : static_cast<const cpp_namespace&>(ns))
+                if (inner.get_entity_type() == cpp_entity::namespace_t)
+                    for (auto& e : static_cast<const cpp_namespace&>(inner))
+                        entities.push_back(&e);
+    std::cout << entities.size() << " entities\n";
+
+    std::size_t no_tokens = 0u, no_bytes = 0u;
+    auto        time      = bm::measure_statistics(options, [&](unsigned) {
+        no_tokens = no_bytes = 0u;
+        for (auto e : entities)
+        {
+            detail::tokenizer tokenizer(tu, e->get_cursor());
+            for (auto token : tokenizer)
+            {
+                ++no_tokens;
+                no_bytes += token.get_value().length();
+            }
+        }
+    });
+    std::cout << no_tokens << " token(s), " << no_bytes << " bytes\n";
+    auto no_runs = options.warmup + std::max(options.iterations, 1u);
+    std::cout << (detail::get_tokenize_count() - parse_calls) / no_runs
+              << " call(s) of clang_tokenize() per iteration\n";
+    bm::print_result("tokenizer (tokens)", time, no_tokens);
+}
@@ -5,11 +5,17 @@
 #ifndef STANDARDESE_COMMENT_HPP_INCLUDED
 #define STANDARDESE_COMMENT_HPP_INCLUDED
 
-#include <map>
+#include <functional>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <standardese/md_entity.hpp>
 #include <standardese/md_blocks.hpp>
+#include <standardese/profiler.hpp>
 
 namespace standardese
 {
@@ -81,17 +87,6 @@ namespace standardese
         friend detail::md_ptr_access;
     };
 
-    class comment_id;
-
-    namespace detail
-    {
-        struct comment_compare
-        {
-            bool operator()(const comment_id& id_a,
-                            const comment_id& id_b) const STANDARDESE_NOEXCEPT;
-        };
-    } // namespace detail
-
     /// The identifier of a comment.
     /// Used to specify the entity it refers to.
     class comment_id
@@ -173,8 +168,6 @@ namespace standardese
 
         string   file_name_or_name_;
         unsigned line_;
-
-        friend detail::comment_compare;
     };
 
     enum class exclude_mode
@@ -210,6 +203,9 @@ namespace standardese
             content_ = std::move(content);
         }
 
+        /// \returns A comment with the same commands but the given content.
+        comment with_content(md_ptr<md_comment> content) const;
+
         bool has_unique_name_override() const STANDARDESE_NOEXCEPT
         {
             return !get_unique_name_override().empty();
@@ -344,23 +340,94 @@ namespace standardese
                                const comment* c);
     }
 
+    /// Stores the comments of all files.
+    /// Comments at a location are kept in line-sorted tables per file,
+    /// comments for a name in a separate hash table.
+    /// Both are split into shards by the hash of the file or name,
+    /// registering comments replaces only the shards that change,
+    /// so lookups don't need to lock.
+    /// A comment that only has commands gets the content of the comment for the name of its entity,
+    /// the merged comment is published the same way, the registered comments are never modified.
     class comment_registry
     {
     public:
+        comment_registry();
+
+        /// \effects Registers a single comment, unless there is already one with the same id.
+        /// \returns Whether or not the comment was registered.
         bool register_comment(comment_id id, comment c) const;
 
+        /// \effects Registers the comments of one file at once,
+        /// comments with an id that is already registered are ignored.
+        /// \returns The number of comments that were registered.
+        std::size_t register_comments(std::vector<std::pair<comment_id, comment>> comments) const;
+
         const comment* lookup_comment(const cpp_entity& e, const doc_entity* parent) const;
 
         const comment* lookup_comment(const std::string& module) const;
 
+        /// \effects Sets the profiler that receives the time spent waiting for a lock.
+        void set_profiler(profiler* p) STANDARDESE_NOEXCEPT
+        {
+            profiler_ = p;
+        }
+
     private:
-        mutable std::mutex mutex_;
-        mutable std::map<comment_id, comment, detail::comment_compare> comments_;
+        struct location_entry
+        {
+            std::string              inline_name; // empty if not for an inline entity
+            unsigned                 line;
+            std::shared_ptr<comment> c;
+        };
+
+        // sorted by inline name, then line
+        using file_table = std::vector<location_entry>;
+
+        using file_map = std::unordered_map<std::string, std::shared_ptr<const file_table>>;
+        using name_map = std::unordered_map<std::string, std::shared_ptr<comment>>;
+        // the registered comment that only has commands and the one with the remote content
+        using remote_map = std::unordered_map<const comment*, std::shared_ptr<const comment>>;
+
+        comment* lookup_location(const cpp_entity& e, const comment_id& id) const;
+
+        comment* lookup_name(const std::string& name) const;
+
+        // returns the comment merged with the remote content or c itself if there is none
+        const comment* add_remote_content(const comment& c, const cpp_entity& e,
+                                          const doc_entity* parent) const;
+
+        static const std::size_t shard_count = 64u;
+
+        static std::size_t get_shard(const std::string& key)
+        {
+            return std::hash<std::string>()(key) % shard_count;
+        }
+
+        static std::size_t get_shard(const comment* c)
+        {
+            return std::hash<const comment*>()(c) % shard_count;
+        }
+
+        // only accessed through std::atomic_load/std::atomic_store
+        mutable std::shared_ptr<const file_map>   files_[shard_count];
+        mutable std::shared_ptr<const name_map>   names_[shard_count];
+        mutable std::shared_ptr<const remote_map> remotes_[shard_count];
+
+        mutable std::mutex write_mutex_;
+        profiler*          profiler_;
     };
 
     class parser;
 
+    namespace detail
+    {
+        struct raw_comment;
+    } // namespace detail
+
     void parse_comments(const parser& p, const char* file_name, const std::string& source);
+
+    void parse_comments(const parser& p, const char* file_name,
+                        const std::vector<detail::raw_comment>& comments);
 } // namespace standardese
 
 #endif // STANDARDESE_COMMENT_HPP_INCLUDED
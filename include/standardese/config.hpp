@@ -33,6 +33,16 @@ namespace standardese
         count,
     };
 
+    /// How the input files are preprocessed.
+    enum class preprocessor_backend
+    {
+        /// Spawns the clang binary with `-E` for each file.
+        external,
+        /// Uses the preprocessing record of the libclang translation unit,
+        /// no additional process is spawned.
+        in_process,
+    };
+
     class compile_config
     {
     public:
@@ -59,6 +69,30 @@ namespace standardese
             return clang_binary_;
         }
 
+        void set_preprocessor_backend(preprocessor_backend backend) STANDARDESE_NOEXCEPT
+        {
+            backend_ = backend;
+        }
+
+        preprocessor_backend get_preprocessor_backend() const STANDARDESE_NOEXCEPT
+        {
+            return backend_;
+        }
+
+        /// \effects Adds a header to the shared preamble.
+        /// The preamble is precompiled once and reused for all files,
+        /// it should contain the (heavy) headers included by most files.
+        /// The time saved per file is logged at debug level,
+        /// it is only an estimate - the build time of the preamble - and not measured.
+        /// `header` is used as-is in an `#include` directive, if it isn't in quotes or angle brackets,
+        /// angle brackets are added.
+        void add_preamble_header(std::string header);
+
+        const std::vector<std::string>& get_preamble_headers() const STANDARDESE_NOEXCEPT
+        {
+            return preamble_;
+        }
+
         std::vector<const char*> get_flags() const;
 
         std::vector<string>::const_iterator begin() const
@@ -72,8 +106,10 @@ namespace standardese
         }
 
     private:
-        std::vector<string> flags_;
-        std::string         clang_binary_;
+        std::vector<string>      flags_;
+        std::vector<std::string> preamble_;
+        std::string              clang_binary_;
+        preprocessor_backend     backend_;
     };
 
     enum class command_type : unsigned;
@@ -5,13 +5,17 @@
 #ifndef STANDARDESE_CPP_ENTITY_HPP_INCLUDED
 #define STANDARDESE_CPP_ENTITY_HPP_INCLUDED
 
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <iterator>
 #include <memory>
 #include <type_traits>
+#include <utility>
 
+#include <standardese/detail/entity_arena.hpp>
 #include <standardese/detail/entity_container.hpp>
+#include <standardese/detail/memoized_name.hpp>
 #include <standardese/cpp_cursor.hpp>
 #include <standardese/noexcept.hpp>
 #include <standardese/string.hpp>
@@ -97,7 +101,19 @@ namespace standardese
 
         cpp_entity& operator=(cpp_entity&&) = delete;
 
+        // while a file is parsed, its entities are allocated in its arena
+        static void* operator new(std::size_t size)
+        {
+            return detail::allocate_entity(detail::entity_arena_scope<cpp_entity>::get(), size);
+        }
+
+        static void operator delete(void* ptr) STANDARDESE_NOEXCEPT
+        {
+            detail::deallocate_entity(ptr);
+        }
+
         /// \returns The name of the entity as specified in the source.
+        /// The default implementation caches the name of the cursor.
         virtual cpp_name get_name() const;
 
         virtual cpp_name get_scope() const;
@@ -105,12 +121,16 @@ namespace standardese
         /// \returns The full name of the entity, scope followed by name.
         cpp_name get_full_name() const
         {
-            auto scope = get_scope();
-            return scope.empty() ? get_name() :
-                                   std::string(scope.c_str()) + "::" + get_name().c_str();
+            return full_name_.get([&]() -> cpp_name {
+                auto scope = get_scope();
+                return scope.empty() ? get_name() :
+                                       std::string(scope.c_str()) + "::" + get_name().c_str();
+            });
         }
 
         /// \returns A unique name describing one entity.
+        /// The names are computed once and cached,
+        /// so they must not be requested before the entity is fully parsed.
         cpp_name get_unique_name(bool exclude_scope = false) const;
 
         /// \returns The type of the entity.
@@ -125,6 +145,13 @@ namespace standardese
             return cursor_;
         }
 
+        /// \returns The file name and line of the first character of the declaration,
+        /// as given by the line directives.
+        /// Like the name it is computed once and cached,
+        /// so it is still available once the translation unit has been released.
+        /// \requires The entity isn't a preprocessor entity.
+        std::pair<cpp_name, unsigned> get_presumed_location() const;
+
         bool has_ast_parent() const STANDARDESE_NOEXCEPT
         {
             return parent_ != nullptr;
@@ -154,6 +181,8 @@ namespace standardese
         void set_cursor(cpp_cursor cur) STANDARDESE_NOEXCEPT
         {
             cursor_ = cur;
+            name_.reset();
+            location_file_.reset();
         }
 
         virtual cpp_name do_get_unique_name() const;
@@ -164,6 +193,18 @@ namespace standardese
             return true;
         }
 
+        void set_parent(const cpp_entity* parent) STANDARDESE_NOEXCEPT
+        {
+            parent_ = parent;
+            full_name_.reset();
+            unique_name_.reset();
+            scoped_unique_name_.reset();
+        }
+
+        detail::memoized_name full_name_, unique_name_, scoped_unique_name_;
+        detail::memoized_name name_, location_file_;
+        mutable std::atomic<unsigned> location_line_; // written before location_file_ is set
+
         cpp_cursor        cursor_;
         cpp_entity_ptr    next_;
         const cpp_entity* parent_;
@@ -253,7 +294,7 @@ namespace standardese
 
             if (this_entity
                 && (!entity->has_ast_parent() || &entity->get_ast_parent() != this_entity))
-                entity->parent_ = this_entity;
+                entity->set_parent(this_entity);
             detail::entity_container<T, cpp_entity, cpp_ptr>::add_entity(std::move(entity));
         }
 
@@ -261,7 +302,7 @@ namespace standardese
         {
             auto entity =
                 detail::entity_container<T, cpp_entity, cpp_ptr>::remove_entity_after(base);
-            entity->parent_ = nullptr;
+            entity->set_parent(nullptr);
             return std::move(entity);
         }
     };
@@ -6,7 +6,7 @@
 #define STANDARDESE_SYNOPSIS_HPP_INCLUDED
 
 #include <bitset>
-#include <set>
+#include <unordered_map>
 
 #include <standardese/cpp_entity.hpp>
 
@@ -49,13 +49,13 @@ namespace standardese
         void blacklist(documentation_t, const cpp_name& name,
                        cpp_entity::type type = cpp_entity::invalid_t)
         {
-            doc_blacklist_.emplace(name, type);
+            doc_blacklist_.emplace(name.share(), type);
         }
 
         void blacklist(synopsis_t, const cpp_name& name,
                        cpp_entity::type type = cpp_entity::invalid_t)
         {
-            synopsis_blacklist_.emplace(name, type);
+            synopsis_blacklist_.emplace(name.share(), type);
         }
 
         void blacklist(const cpp_name& name, cpp_entity::type type = cpp_entity::invalid_t)
@@ -96,7 +96,10 @@ namespace standardese
         bool is_blacklisted(synopsis_t, const cpp_entity& e) const;
 
     private:
-        std::set<std::pair<cpp_name, cpp_entity::type>> doc_blacklist_, synopsis_blacklist_;
+        // the names are shared, so copying a blacklist doesn't copy them
+        using name_blacklist = std::unordered_multimap<cpp_name, cpp_entity::type>;
+
+        name_blacklist                     doc_blacklist_, synopsis_blacklist_;
         std::bitset<cpp_entity::invalid_t> type_blacklist_;
         int                                options_ = 0;
     };
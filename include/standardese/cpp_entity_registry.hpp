@@ -5,44 +5,65 @@
 #ifndef STANDARDESE_CPP_ENTITY_REGISTRY_HPP_INCLUDED
 #define STANDARDESE_CPP_ENTITY_REGISTRY_HPP_INCLUDED
 
-#include <map>
+#include <array>
 #include <mutex>
+#include <string>
+#include <unordered_map>
 
 #include <standardese/detail/parse_utils.hpp>
 #include <standardese/cpp_entity.hpp>
+#include <standardese/profiler.hpp>
 
 namespace standardese
 {
     class cpp_entity_registry
     {
     public:
-        void register_entity(const cpp_entity& e) const
+        cpp_entity_registry() STANDARDESE_NOEXCEPT : profiler_(nullptr)
         {
-            std::unique_lock<std::mutex> lock(mutex_);
-            if (!string(clang_getCursorUSR(e.get_cursor())).empty())
-                map_.emplace(e.get_cursor(), &e);
         }
 
-        const cpp_entity* try_lookup(const cpp_cursor& cur) const STANDARDESE_NOEXCEPT
+        /// \effects Registers an entity under the USR of its cursor,
+        /// an entity that is already registered under the same USR is kept.
+        /// Entities without USR are ignored.
+        void register_entity(const cpp_entity& e) const;
+
+        /// \returns The entity registered under the USR of the cursor or `nullptr`.
+        const cpp_entity* try_lookup(const cpp_cursor& cur) const STANDARDESE_NOEXCEPT;
+
+        /// \returns The number of registered entities.
+        std::size_t size() const STANDARDESE_NOEXCEPT;
+
+        /// \effects Sets the profiler that receives the time spent waiting for a lock.
+        void set_profiler(profiler* p) STANDARDESE_NOEXCEPT
         {
-            std::unique_lock<std::mutex> lock(mutex_);
-            if (string(clang_getCursorUSR(cur)).empty())
-                return nullptr;
-            auto iter = map_.find(cur);
-            return iter == map_.end() ? nullptr : iter->second;
+            profiler_ = p;
         }
 
     private:
-        struct cursor_less
+        struct entry
         {
-            bool operator()(const cpp_cursor& a, const cpp_cursor& b) const STANDARDESE_NOEXCEPT
-            {
-                return string(clang_getCursorUSR(a)) < string(clang_getCursorUSR(b));
-            }
+            cpp_name          usr;
+            const cpp_entity* entity;
+        };
+
+        // the entities are distributed over the shards by the hash of their USR,
+        // so that concurrent lookups rarely wait for the same mutex
+        struct shard
+        {
+            mutable std::mutex mutex;
+            std::unordered_multimap<std::size_t, entry> map;
         };
 
-        mutable std::mutex mutex_;
-        mutable std::map<cpp_cursor, const cpp_entity*, cursor_less> map_;
+        static const std::size_t shard_count = 16u;
+
+        shard& get_shard(std::size_t hash) const STANDARDESE_NOEXCEPT
+        {
+            return shards_[hash % shard_count];
+        }
+
+        mutable std::array<shard, shard_count> shards_;
+        profiler*                              profiler_;
     };
 
     template <CXCursorKind Kind>
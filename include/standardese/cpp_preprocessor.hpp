@@ -16,6 +16,11 @@ namespace standardese
     class compile_config;
     class cpp_file;
 
+    namespace detail
+    {
+        class token_buffer;
+    } // namespace detail
+
     class cpp_inclusion_directive : public cpp_entity
     {
     public:
@@ -82,10 +87,9 @@ namespace standardese
             return cpp_entity::macro_definition_t;
         }
 
-        static cpp_ptr<standardese::cpp_macro_definition> parse(CXTranslationUnit tu, CXFile file,
-                                                                cpp_cursor        cur,
-                                                                const cpp_entity& parent,
-                                                                unsigned          line_no);
+        static cpp_ptr<standardese::cpp_macro_definition> parse(
+            CXTranslationUnit tu, CXFile file, cpp_cursor cur, const cpp_entity& parent,
+            unsigned line_no, const detail::token_buffer* buffer = nullptr);
 
         cpp_name get_name() const override
         {
@@ -136,6 +140,15 @@ namespace standardese
         std::string preprocess(const parser& p, const compile_config& c, const char* full_path,
                                cpp_file& file) const;
 
+        /// \effects Adds the macro definitions of the parsed file.
+        /// For the in-process backend, where `preprocess()` returns the source
+        /// with only the friend definitions rewritten,
+        /// it also adds the inclusion directives and blanks out skipped preprocessor blocks in `source`.
+        /// \requires `tu` must have been parsed from the result of `preprocess()`
+        /// with a detailed preprocessing record.
+        void process_directives(const parser& p, const compile_config& c, CXTranslationUnit tu,
+                                const char* full_path, cpp_file& file, std::string& source) const;
+
         void whitelist_include_dir(std::string dir);
 
         bool is_whitelisted_directory(std::string& dir) const STANDARDESE_NOEXCEPT;
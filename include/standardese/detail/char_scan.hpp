@@ -0,0 +1,159 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_DETAIL_CHAR_SCAN_HPP_INCLUDED
+#define STANDARDESE_DETAIL_CHAR_SCAN_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define STANDARDESE_DETAIL_CHAR_SCAN_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define STANDARDESE_DETAIL_CHAR_SCAN_SSE2 1
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include <standardese/noexcept.hpp>
+
+namespace standardese
+{
+    namespace detail
+    {
+        // a block of characters that is compared with a character at once,
+        // using AVX2 or SSE2 if the compiler targets them
+        class char_block
+        {
+        public:
+#if defined(STANDARDESE_DETAIL_CHAR_SCAN_AVX2)
+            static const std::size_t size = 32u;
+
+            explicit char_block(const char* ptr) STANDARDESE_NOEXCEPT
+            : data_(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr)))
+            {
+            }
+
+            // bit i is set if the i-th character is c
+            std::uint32_t match(char c) const STANDARDESE_NOEXCEPT
+            {
+                return static_cast<std::uint32_t>(
+                    _mm256_movemask_epi8(_mm256_cmpeq_epi8(data_, _mm256_set1_epi8(c))));
+            }
+
+        private:
+            __m256i data_;
+#elif defined(STANDARDESE_DETAIL_CHAR_SCAN_SSE2)
+            static const std::size_t size = 16u;
+
+            explicit char_block(const char* ptr) STANDARDESE_NOEXCEPT
+            : data_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr)))
+            {
+            }
+
+            // bit i is set if the i-th character is c
+            std::uint32_t match(char c) const STANDARDESE_NOEXCEPT
+            {
+                return static_cast<std::uint32_t>(
+                    _mm_movemask_epi8(_mm_cmpeq_epi8(data_, _mm_set1_epi8(c))));
+            }
+
+        private:
+            __m128i data_;
+#else
+            static const std::size_t size = 8u;
+
+            explicit char_block(const char* ptr) STANDARDESE_NOEXCEPT
+            {
+                std::memcpy(data_, ptr, size);
+            }
+
+            // bit i is set if the i-th character is c
+            std::uint32_t match(char c) const STANDARDESE_NOEXCEPT
+            {
+                std::uint32_t result = 0u;
+                for (auto i = 0u; i != size; ++i)
+                    result |= std::uint32_t(data_[i] == c) << i;
+                return result;
+            }
+
+        private:
+            char data_[size];
+#endif
+        };
+
+        // mask must not be zero
+        inline unsigned count_trailing_zeros(std::uint32_t mask) STANDARDESE_NOEXCEPT
+        {
+#if defined(__GNUC__)
+            return unsigned(__builtin_ctz(mask));
+#elif defined(_MSC_VER)
+            unsigned long result;
+            _BitScanForward(&result, mask);
+            return unsigned(result);
+#else
+            auto result = 0u;
+            for (; (mask & 1u) == 0u; mask >>= 1u)
+                ++result;
+            return result;
+#endif
+        }
+
+        inline unsigned count_bits(std::uint32_t mask) STANDARDESE_NOEXCEPT
+        {
+#if defined(__GNUC__)
+            return unsigned(__builtin_popcount(mask));
+#else
+            mask = mask - ((mask >> 1u) & 0x55555555u);
+            mask = (mask & 0x33333333u) + ((mask >> 2u) & 0x33333333u);
+            return unsigned((((mask + (mask >> 4u)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24u);
+#endif
+        }
+
+        // returns the first c in [begin, end) or end
+        inline const char* find_char(const char* begin, const char* end,
+                                     char c) STANDARDESE_NOEXCEPT
+        {
+            if (begin >= end)
+                return end;
+            auto result = std::memchr(begin, c, std::size_t(end - begin));
+            return result ? static_cast<const char*>(result) : end;
+        }
+
+        // returns the first a or b in [begin, end) or end
+        inline const char* find_first_of(const char* begin, const char* end, char a,
+                                         char b) STANDARDESE_NOEXCEPT
+        {
+            for (; begin + char_block::size <= end; begin += char_block::size)
+            {
+                char_block block(begin);
+                if (auto mask = block.match(a) | block.match(b))
+                    return begin + count_trailing_zeros(mask);
+            }
+            for (; begin < end; ++begin)
+                if (*begin == a || *begin == b)
+                    return begin;
+            return end;
+        }
+
+        // returns the number of c in [begin, end)
+        inline std::size_t count_char(const char* begin, const char* end,
+                                      char c) STANDARDESE_NOEXCEPT
+        {
+            std::size_t result = 0u;
+            for (; begin + char_block::size <= end; begin += char_block::size)
+                result += count_bits(char_block(begin).match(c));
+            for (; begin < end; ++begin)
+                result += std::size_t(*begin == c);
+            return result;
+        }
+    } // namespace detail
+} // namespace standardese
+
+#endif // STANDARDESE_DETAIL_CHAR_SCAN_HPP_INCLUDED
@@ -0,0 +1,108 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_DETAIL_ENTITY_ARENA_HPP_INCLUDED
+#define STANDARDESE_DETAIL_ENTITY_ARENA_HPP_INCLUDED
+
+#include <cstddef>
+#include <memory>
+
+#include <standardese/noexcept.hpp>
+
+namespace standardese
+{
+    namespace detail
+    {
+        // a bump allocator for the entities of a file
+        // the memory is only freed as a whole when the arena is destroyed,
+        // so the entities are close to each other, in the order they were parsed
+        class entity_arena
+        {
+        public:
+            entity_arena() STANDARDESE_NOEXCEPT : blocks_(nullptr),
+                                                  cur_(nullptr),
+                                                  end_(nullptr),
+                                                  usage_(0u)
+            {
+            }
+
+            entity_arena(const entity_arena&) = delete;
+
+            ~entity_arena() STANDARDESE_NOEXCEPT;
+
+            entity_arena& operator=(const entity_arena&) = delete;
+
+            // aligned for any type
+            void* allocate(std::size_t size);
+
+            // the size of all blocks
+            std::size_t get_memory_usage() const STANDARDESE_NOEXCEPT
+            {
+                return usage_;
+            }
+
+        private:
+            struct block;
+
+            block*      blocks_;
+            char*       cur_;
+            char*       end_;
+            std::size_t usage_;
+        };
+
+        // sets the arena the entities derived from Base are allocated in by the current thread,
+        // the previous arena is restored by the destructor
+        // nullptr allocates them on the heap
+        template <class Base>
+        class entity_arena_scope
+        {
+        public:
+            explicit entity_arena_scope(entity_arena* arena) STANDARDESE_NOEXCEPT
+            : prev_(get_current())
+            {
+                get_current() = arena;
+            }
+
+            entity_arena_scope(const entity_arena_scope&) = delete;
+
+            ~entity_arena_scope() STANDARDESE_NOEXCEPT
+            {
+                get_current() = prev_;
+            }
+
+            entity_arena_scope& operator=(const entity_arena_scope&) = delete;
+
+            static entity_arena* get() STANDARDESE_NOEXCEPT
+            {
+                return get_current();
+            }
+
+        private:
+            static entity_arena*& get_current() STANDARDESE_NOEXCEPT
+            {
+                static thread_local entity_arena* arena = nullptr;
+                return arena;
+            }
+
+            entity_arena* prev_;
+        };
+
+        // allocates an entity in the arena or on the heap if it is nullptr
+        void* allocate_entity(entity_arena* arena, std::size_t size);
+
+        // frees an entity that was allocated on the heap,
+        // the memory of an entity in an arena is freed with the arena
+        void deallocate_entity(void* ptr) STANDARDESE_NOEXCEPT;
+
+        // the arena of a file
+        // it must be the first base class of the file, so that it is destroyed after the entities
+        class entity_arena_owner
+        {
+        protected:
+            std::shared_ptr<entity_arena> arena_; // shared between the files of a unity parse
+        };
+    } // namespace detail
+} // namespace standardese
+
+#endif // STANDARDESE_DETAIL_ENTITY_ARENA_HPP_INCLUDED
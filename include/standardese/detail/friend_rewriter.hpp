@@ -0,0 +1,85 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_DETAIL_FRIEND_REWRITER_HPP_INCLUDED
+#define STANDARDESE_DETAIL_FRIEND_REWRITER_HPP_INCLUDED
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <standardese/noexcept.hpp>
+
+namespace standardese
+{
+    namespace detail
+    {
+        // replaces the friend keyword of friend function definitions with __standardese_friend,
+        // so that libclang reports them as functions and they can be told apart from declarations
+        // the source is rewritten while it is produced:
+        // text is appended to the string and rewrite() scans what was appended since the last call
+        // the keyword is only matched as a whole identifier outside of comments and literals
+        class friend_rewriter
+        {
+        public:
+            explicit friend_rewriter(std::string& source) STANDARDESE_NOEXCEPT
+            : source_(&source),
+              scanned_(0u),
+              keyword_(0u),
+              paren_count_(0),
+              state_(state::code),
+              pending_(false)
+            {
+            }
+
+            friend_rewriter(const friend_rewriter&) = delete;
+            friend_rewriter& operator=(const friend_rewriter&) = delete;
+
+            // scans the appended text,
+            // except for the last few characters, which could be the beginning of a keyword
+            void rewrite()
+            {
+                scan(false);
+            }
+
+            // scans the rest of the source and replaces the keywords
+            // nothing must be appended afterwards
+            void finish();
+
+            // the number of friend function definitions found so far
+            std::size_t get_definition_count() const STANDARDESE_NOEXCEPT
+            {
+                return definitions_.size();
+            }
+
+        private:
+            enum class state
+            {
+                code,
+                line_comment,
+                block_comment,
+                string_literal,
+                char_literal,
+            };
+
+            void scan(bool finish);
+
+            std::string*             source_;
+            std::vector<std::size_t> definitions_; // the offsets of the keywords to replace
+            std::size_t              scanned_;     // everything before it has been scanned
+            std::size_t              keyword_;     // the offset of the pending keyword
+            int                      paren_count_;
+            state                    state_;
+            bool                     pending_; // whether a declaration after friend is scanned
+        };
+
+        // rewrites the friend definitions of a complete source
+        inline void rewrite_friend_definitions(std::string& source)
+        {
+            friend_rewriter(source).finish();
+        }
+    } // namespace detail
+} // namespace standardese
+
+#endif // STANDARDESE_DETAIL_FRIEND_REWRITER_HPP_INCLUDED
@@ -0,0 +1,92 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_DETAIL_MEMOIZED_NAME_HPP_INCLUDED
+#define STANDARDESE_DETAIL_MEMOIZED_NAME_HPP_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+
+#include <standardese/noexcept.hpp>
+#include <standardese/string.hpp>
+
+namespace standardese
+{
+    namespace detail
+    {
+        struct name_statistics
+        {
+            std::size_t computed; // number of names that had to be computed
+            std::size_t cached;   // number of names that were returned from the cache
+        };
+
+        /// \returns The statistics of all memoized names since the start of the program.
+        name_statistics get_name_statistics() STANDARDESE_NOEXCEPT;
+
+        // the counters are per thread, so counting doesn't write to shared memory
+        void count_computed_name() STANDARDESE_NOEXCEPT;
+        void count_cached_name() STANDARDESE_NOEXCEPT;
+
+        // a name of an entity that is computed on first use
+        // get() can be called concurrently, if multiple threads compute it at the same time,
+        // the first result is kept
+        // the returned strings borrow the characters of the name,
+        // so a cached read neither allocates nor writes to the reference count,
+        // only copies and moves of them take a reference
+        class memoized_name
+        {
+        public:
+            memoized_name() STANDARDESE_NOEXCEPT : name_(nullptr)
+            {
+            }
+
+            memoized_name(const memoized_name&) = delete;
+
+            ~memoized_name() STANDARDESE_NOEXCEPT
+            {
+                if (auto name = name_.load(std::memory_order_relaxed))
+                    name->release();
+            }
+
+            memoized_name& operator=(const memoized_name&) = delete;
+
+            template <typename Func>
+            string get(Func compute) const
+            {
+                auto name = name_.load(std::memory_order_acquire);
+                if (name)
+                    count_cached_name();
+                else
+                {
+                    auto           result = compute();
+                    auto           ptr    = string_atom::create(result.c_str(), result.length());
+                    decltype(name) expected(nullptr);
+                    if (name_.compare_exchange_strong(expected, ptr, std::memory_order_acq_rel))
+                        name = ptr;
+                    else
+                    {
+                        ptr->release();
+                        name = expected;
+                    }
+                    count_computed_name();
+                }
+
+                return string::borrow(*name);
+            }
+
+            // forgets the name, e.g. because the parent of the entity has changed
+            // must not be called concurrently with get()
+            void reset() STANDARDESE_NOEXCEPT
+            {
+                if (auto name = name_.exchange(nullptr))
+                    name->release();
+            }
+
+        private:
+            mutable std::atomic<const string_atom*> name_;
+        };
+    } // namespace detail
+} // namespace standardese
+
+#endif // STANDARDESE_DETAIL_MEMOIZED_NAME_HPP_INCLUDED
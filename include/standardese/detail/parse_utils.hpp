@@ -5,6 +5,7 @@
 #ifndef STANDARDESE_PARSE_UTILS_HPP_INCLUDED
 #define STANDARDESE_PARSE_UTILS_HPP_INCLUDED
 
+#include <standardese/detail/token_buffer.hpp>
 #include <standardese/cpp_entity.hpp>
 
 namespace standardese
@@ -30,7 +31,17 @@ namespace standardese
 
         // appends a token to a string
         // inserts whitespace if needed
-        void append_token(std::string& result, const string& token);
+        void append_token(std::string& result, const char* token);
+
+        inline void append_token(std::string& result, const string& token)
+        {
+            append_token(result, token.c_str());
+        }
+
+        inline void append_token(std::string& result, const token_spelling& token)
+        {
+            append_token(result, token.c_str());
+        }
 
         // erases template arguments
         void erase_template_args(std::string& name);
@@ -0,0 +1,237 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_DETAIL_TOKEN_BUFFER_HPP_INCLUDED
+#define STANDARDESE_DETAIL_TOKEN_BUFFER_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include <clang-c/Index.h>
+
+#include <standardese/noexcept.hpp>
+#include <standardese/string.hpp>
+
+namespace standardese
+{
+    namespace detail
+    {
+        // calls clang_tokenize() and counts the call
+        void tokenize(CXTranslationUnit tu, CXSourceRange range, CXToken** tokens,
+                      unsigned* no_tokens);
+
+        // returns the number of calls to clang_tokenize() of all threads
+        std::size_t get_tokenize_count() STANDARDESE_NOEXCEPT;
+
+        // the spelling of a token
+        // it doesn't own the characters, they are owned by the token buffer
+        class token_spelling
+        {
+        public:
+            token_spelling(const char* str) STANDARDESE_NOEXCEPT : str_(str),
+                                                                   length_(std::strlen(str))
+            {
+            }
+
+            token_spelling(const char* str, std::size_t length) STANDARDESE_NOEXCEPT
+            : str_(str),
+              length_(length)
+            {
+            }
+
+            // null-terminated
+            const char* c_str() const STANDARDESE_NOEXCEPT
+            {
+                return str_;
+            }
+
+            char operator[](std::size_t i) const STANDARDESE_NOEXCEPT
+            {
+                return str_[i];
+            }
+
+            bool empty() const STANDARDESE_NOEXCEPT
+            {
+                return length_ == 0u;
+            }
+
+            std::size_t length() const STANDARDESE_NOEXCEPT
+            {
+                return length_;
+            }
+
+            const char* begin() const STANDARDESE_NOEXCEPT
+            {
+                return str_;
+            }
+
+            const char* end() const STANDARDESE_NOEXCEPT
+            {
+                return str_ + length_;
+            }
+
+        private:
+            const char* str_;
+            std::size_t length_;
+        };
+
+        inline bool operator==(const token_spelling& a, const token_spelling& b)
+            STANDARDESE_NOEXCEPT
+        {
+            return a.length() == b.length() && std::memcmp(a.c_str(), b.c_str(), a.length()) == 0;
+        }
+
+        inline bool operator==(const token_spelling& a, const char* b) STANDARDESE_NOEXCEPT
+        {
+            // the first character already differs for most comparisons
+            return a[0] == b[0] && std::strcmp(a.c_str(), b) == 0;
+        }
+
+        inline bool operator==(const char* a, const token_spelling& b) STANDARDESE_NOEXCEPT
+        {
+            return b == a;
+        }
+
+        inline bool operator==(const token_spelling& a, const string& b) STANDARDESE_NOEXCEPT
+        {
+            return a == b.c_str();
+        }
+
+        inline bool operator==(const string& a, const token_spelling& b) STANDARDESE_NOEXCEPT
+        {
+            return b == a.c_str();
+        }
+
+        template <typename T>
+        bool operator!=(const token_spelling& a, const T& b) STANDARDESE_NOEXCEPT
+        {
+            return !(a == b);
+        }
+
+        template <typename T>
+        bool operator!=(const T& a, const token_spelling& b) STANDARDESE_NOEXCEPT
+        {
+            return !(a == b);
+        }
+
+        inline bool operator!=(const token_spelling& a, const token_spelling& b)
+            STANDARDESE_NOEXCEPT
+        {
+            return !(a == b);
+        }
+
+        class token
+        {
+        public:
+            token() : token("", CXToken_Punctuation)
+            {
+            }
+
+            token(token_spelling value, CXTokenKind kind, unsigned offset = 0)
+            : value_(value), kind_(kind), offset_(offset)
+            {
+            }
+
+            const token* operator->() const STANDARDESE_NOEXCEPT
+            {
+                return this;
+            }
+
+            token_spelling get_value() const STANDARDESE_NOEXCEPT
+            {
+                return value_;
+            }
+
+            CXTokenKind get_kind() const STANDARDESE_NOEXCEPT
+            {
+                return kind_;
+            }
+
+            unsigned get_offset() const STANDARDESE_NOEXCEPT
+            {
+                return offset_;
+            }
+
+        private:
+            token_spelling value_;
+            CXTokenKind    kind_;
+            unsigned       offset_;
+        };
+
+        // tokens together with their spellings, which are only materialized once
+        // the tokens of an entire file are tokenized once after parsing,
+        // the tokenizers of the entities are slices of it
+        class token_buffer
+        {
+        public:
+            token_buffer() STANDARDESE_NOEXCEPT : file_(nullptr)
+            {
+            }
+
+            // tokenizes the range
+            token_buffer(CXTranslationUnit tu, CXSourceRange range);
+
+            // tokenizes the first size bytes of the file
+            token_buffer(CXTranslationUnit tu, CXFile file, unsigned size);
+
+            // the tokens refer to the spellings, so a copy would refer to the original,
+            // moving keeps the storage of the spellings
+            token_buffer(const token_buffer&) = delete;
+            token_buffer(token_buffer&&)      = default;
+
+            token_buffer& operator=(const token_buffer&) = delete;
+            token_buffer& operator=(token_buffer&&) = default;
+
+            bool empty() const STANDARDESE_NOEXCEPT
+            {
+                return tokens_.empty();
+            }
+
+            CXFile get_cxfile() const STANDARDESE_NOEXCEPT
+            {
+                return file_;
+            }
+
+            const token* begin() const STANDARDESE_NOEXCEPT
+            {
+                return tokens_.data();
+            }
+
+            const token* end() const STANDARDESE_NOEXCEPT
+            {
+                return tokens_.data() + tokens_.size();
+            }
+
+            unsigned get_end_offset(const token* t) const STANDARDESE_NOEXCEPT
+            {
+                return end_offsets_[std::size_t(t - begin())];
+            }
+
+            // returns the first token that starts at or after the offset,
+            // or nullptr if the offset is inside a token
+            // as comments are tokens as well, there is only whitespace between the tokens
+            const token* find(unsigned offset) const STANDARDESE_NOEXCEPT;
+
+            // returns the tokens clang_tokenize() would return for the range
+            // or false if the range doesn't start at the boundary of a token of the buffer
+            bool get_tokens(CXSourceRange range, const token*& begin,
+                            const token*& end) const STANDARDESE_NOEXCEPT;
+
+            std::size_t get_memory_usage() const STANDARDESE_NOEXCEPT
+            {
+                return tokens_.capacity() * sizeof(token)
+                       + end_offsets_.capacity() * sizeof(unsigned) + spellings_.capacity();
+            }
+
+        private:
+            std::vector<token>    tokens_;
+            std::vector<unsigned> end_offsets_;
+            std::vector<char>     spellings_; // null-terminated, referred to by the tokens
+            CXFile                file_;
+        };
+    }
+} // namespace standardese::detail
+
+#endif // STANDARDESE_DETAIL_TOKEN_BUFFER_HPP_INCLUDED
@@ -9,6 +9,7 @@
 #include <string>
 
 #include <standardese/detail/sequence_stream.hpp>
+#include <standardese/detail/token_buffer.hpp>
 #include <standardese/string.hpp>
 #include <standardese/cpp_cursor.hpp>
 #include <standardese/translation_unit.hpp>
@@ -28,207 +29,31 @@ namespace standardese
 
         CXFile get_range(CXSourceRange extent, unsigned& begin_offset, unsigned& end_offset);
 
-        class token
-        {
-        public:
-            token() : token("", CXToken_Punctuation)
-            {
-            }
-
-            token(string value, CXTokenKind kind, unsigned offset = 0)
-            : value_(value), kind_(kind), offset_(offset)
-            {
-            }
-
-            token(CXTranslationUnit tu, CXToken token);
-
-            const token* operator->() const STANDARDESE_NOEXCEPT
-            {
-                return this;
-            }
-
-            string get_value() const STANDARDESE_NOEXCEPT
-            {
-                return value_;
-            }
-
-            CXTokenKind get_kind() const STANDARDESE_NOEXCEPT
-            {
-                return kind_;
-            }
-
-            unsigned get_offset() const STANDARDESE_NOEXCEPT
-            {
-                return offset_;
-            }
-
-        private:
-            string      value_;
-            CXTokenKind kind_;
-            unsigned    offset_;
-        };
-
-        class token_iterator : public std::iterator<std::random_access_iterator_tag, token>
-        {
-        public:
-            token operator*() const STANDARDESE_NOEXCEPT
-            {
-                return token(tu_, *cx_token_);
-            }
-
-            token operator->() const STANDARDESE_NOEXCEPT
-            {
-                return token(tu_, *cx_token_);
-            }
-
-            token_iterator& operator++() STANDARDESE_NOEXCEPT
-            {
-                ++cx_token_;
-                return *this;
-            }
-
-            token_iterator operator++(int)STANDARDESE_NOEXCEPT
-            {
-                token_iterator tmp(*this);
-                ++*this;
-                return tmp;
-            }
-
-            token_iterator& operator--() STANDARDESE_NOEXCEPT
-            {
-                --cx_token_;
-                return *this;
-            }
-
-            token_iterator operator--(int)STANDARDESE_NOEXCEPT
-            {
-                token_iterator tmp(*this);
-                --*this;
-                return tmp;
-            }
-
-            token_iterator& operator+=(std::ptrdiff_t d) STANDARDESE_NOEXCEPT
-            {
-                cx_token_ += d;
-                return *this;
-            }
-
-            token_iterator& operator-=(std::ptrdiff_t d) STANDARDESE_NOEXCEPT
-            {
-                cx_token_ -= d;
-                return *this;
-            }
-
-            token operator[](std::ptrdiff_t d) const STANDARDESE_NOEXCEPT
-            {
-                return token(tu_, cx_token_[d]);
-            }
-
-            friend bool operator==(const token_iterator& a,
-                                   const token_iterator& b) STANDARDESE_NOEXCEPT
-            {
-                return a.cx_token_ == b.cx_token_;
-            }
-
-            friend bool operator!=(const token_iterator& a,
-                                   const token_iterator& b) STANDARDESE_NOEXCEPT
-            {
-                return !(a == b);
-            }
-
-            friend token_iterator operator+(const token_iterator& iter,
-                                            std::ptrdiff_t        d) STANDARDESE_NOEXCEPT
-            {
-                return token_iterator(iter.tu_, iter.cx_token_ + d);
-            }
-
-            friend token_iterator operator+(std::ptrdiff_t        d,
-                                            const token_iterator& iter) STANDARDESE_NOEXCEPT
-            {
-                return iter + d;
-            }
-
-            friend token_iterator operator-(const token_iterator& iter,
-                                            std::ptrdiff_t        d) STANDARDESE_NOEXCEPT
-            {
-                return token_iterator(iter.tu_, iter.cx_token_ - d);
-            }
-
-            friend token_iterator operator-(std::ptrdiff_t        d,
-                                            const token_iterator& iter) STANDARDESE_NOEXCEPT
-            {
-                return iter - d;
-            }
-
-            friend std::ptrdiff_t operator-(const token_iterator& a,
-                                            const token_iterator& b) STANDARDESE_NOEXCEPT
-            {
-                return a.cx_token_ - b.cx_token_;
-            }
-
-            friend bool operator<(const token_iterator& lhs, const token_iterator& rhs)
-            {
-                return lhs.cx_token_ < rhs.cx_token_;
-            }
-
-            friend bool operator>(const token_iterator& lhs, const token_iterator& rhs)
-            {
-                return rhs < lhs;
-            }
-
-            friend bool operator<=(const token_iterator& lhs, const token_iterator& rhs)
-            {
-                return !(rhs < lhs);
-            }
-
-            friend bool operator>=(const token_iterator& lhs, const token_iterator& rhs)
-            {
-                return !(lhs < rhs);
-            }
-
-        private:
-            token_iterator(CXTranslationUnit tu, CXToken* token) STANDARDESE_NOEXCEPT
-                : tu_(tu),
-                  cx_token_(token)
-            {
-            }
-
-            CXTranslationUnit tu_;
-            CXToken*          cx_token_;
-
-            friend class tokenizer;
-        };
+        // the tokens are stored in a buffer, so the iterator is simply a pointer
+        using token_iterator = const token*;
 
         class tokenizer
         {
         public:
-            tokenizer(CXTranslationUnit tu, CXFile file, cpp_cursor cur);
-
-            tokenizer(const translation_unit& tu, cpp_cursor cur)
-            : tokenizer(tu.get_cxunit(), tu.get_cxfile(), cur)
-            {
-            }
+            // if there is a buffer, the tokens are taken from it whenever possible
+            tokenizer(CXTranslationUnit tu, CXFile file, cpp_cursor cur,
+                      const token_buffer* buffer = nullptr);
 
-            tokenizer(tokenizer&& other) STANDARDESE_NOEXCEPT : tu_(other.tu_),
-                                                                file_(other.file_),
-                                                                tokens_(other.tokens_),
-                                                                no_tokens_(other.no_tokens_),
-                                                                end_offset_(other.end_offset_),
-                                                                end_(other.end_)
-            {
-                other.tokens_ = nullptr;
-            }
+            tokenizer(const translation_unit& tu, cpp_cursor cur);
 
-            ~tokenizer() STANDARDESE_NOEXCEPT;
+            tokenizer(tokenizer&&) = default;
 
             tokenizer& operator=(tokenizer&&) = delete;
 
             token_iterator begin() const STANDARDESE_NOEXCEPT
             {
-                return token_iterator(get_cxunit(), tokens_);
+                return begin_;
             }
 
-            token_iterator end() const STANDARDESE_NOEXCEPT;
+            token_iterator end() const STANDARDESE_NOEXCEPT
+            {
+                return end_;
+            }
 
             // returns whether two '>' characters at the end were munched into a single '>>'
             // only necessary for template parameter
@@ -246,15 +71,17 @@ namespace standardese
 
             token end_token() const STANDARDESE_NOEXCEPT
             {
-                return token(end_, CXToken_Punctuation);
+                return token(end_token_, CXToken_Punctuation);
             }
 
         private:
-            CXTranslationUnit tu_;
-            CXFile            file_;
-            CXToken*          tokens_;
-            unsigned          no_tokens_, end_offset_;
-            const char*       end_;
+            CXTranslationUnit   tu_;
+            CXFile              file_;
+            const token_buffer* buffer_;
+            token_buffer        owned_; // empty if the tokens are part of the buffer
+            token_iterator      begin_, end_;
+            unsigned            end_offset_;
+            const char*         end_token_;
         };
 
         using token_stream = sequence_stream<token_iterator>;
@@ -7,6 +7,7 @@
 
 #include <memory>
 
+#include <standardese/detail/entity_arena.hpp>
 #include <standardese/detail/entity_container.hpp>
 #include <standardese/cpp_entity.hpp>
 #include <standardese/md_custom.hpp>
@@ -63,6 +64,17 @@ namespace standardese
         doc_entity& operator=(const doc_entity&) = delete;
         doc_entity& operator=(doc_entity&&) = delete;
 
+        // while a file is parsed, its entities are allocated in its arena
+        static void* operator new(std::size_t size)
+        {
+            return detail::allocate_entity(detail::entity_arena_scope<doc_entity>::get(), size);
+        }
+
+        static void operator delete(void* ptr) STANDARDESE_NOEXCEPT
+        {
+            detail::deallocate_entity(ptr);
+        }
+
         type get_entity_type() const STANDARDESE_NOEXCEPT
         {
             return t_;
@@ -72,12 +84,13 @@ namespace standardese
 
         cpp_name get_name() const
         {
-            return do_get_name();
+            return name_.get([&] { return do_get_name(); });
         }
 
         cpp_name get_index_name(bool full_name, bool signature) const
         {
-            return do_get_index_name(full_name, signature);
+            return index_names_[full_name * 2 + signature].get(
+                [&] { return do_get_index_name(full_name, signature); });
         }
 
         cpp_entity::type get_cpp_entity_type() const STANDARDESE_NOEXCEPT
@@ -145,6 +158,7 @@ namespace standardese
         void set_parent(const doc_entity* parent)
         {
             parent_ = parent;
+            unique_name_.reset();
         }
 
         virtual void do_generate_documentation(const parser& p, const index& i, md_document& doc,
@@ -165,6 +179,8 @@ namespace standardese
 
         virtual cpp_entity::type do_get_cpp_entity_type() const STANDARDESE_NOEXCEPT = 0;
 
+        detail::memoized_name name_, unique_name_, index_names_[4];
+
         doc_entity_ptr    next_;
         const doc_entity* parent_;
         const comment*    comment_;
@@ -409,7 +425,7 @@ namespace standardese
         friend detail::doc_ptr_access;
     };
 
-    class doc_file final : public doc_entity
+    class doc_file final : private detail::entity_arena_owner, public doc_entity
     {
     public:
         static doc_ptr<doc_file> parse(const parser& p, const index& i, std::string output_name,
@@ -440,6 +456,11 @@ namespace standardese
             return output_name_;
         }
 
+        const doc_entity& get_container() const STANDARDESE_NOEXCEPT
+        {
+            return *file_;
+        }
+
     protected:
         void do_generate_documentation(const parser& p, const index& i, md_document& doc,
                                        unsigned level) const override;
@@ -32,6 +32,12 @@ namespace standardese
     documentation generate_doc_file(const parser& p, const index& i, const cpp_file& f,
                                     std::string name);
 
+    /// \effects Computes and caches all names of the documented entities of the file
+    /// that the index, linker and output need after the documentation has been generated.
+    /// Afterwards the libclang translation unit of the file can be released,
+    /// unless the entities are used to generate documentation again, e.g. by a template.
+    void detach_doc_file(const documentation& doc);
+
     class doc_index final : public doc_entity
     {
     protected:
@@ -5,9 +5,10 @@
 #ifndef STANDARDESE_INDEX_HPP_INCLUDED
 #define STANDARDESE_INDEX_HPP_INCLUDED
 
-#include <map>
+#include <atomic>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <standardese/doc_entity.hpp>
@@ -33,6 +34,21 @@ namespace standardese
         void register_entity(const parser& p, const doc_entity& entity,
                              std::string output_name) const;
 
+        /// \effects Same as above, but uses the given anchor id for the link location.
+        void register_entity(const parser& p, const doc_entity& entity, std::string output_name,
+                             std::string anchor_id) const;
+
+        /// \effects Ends the registration phase,
+        /// the tables are converted into sorted arrays that can be read without locking.
+        /// Entities must not be registered afterwards.
+        /// It is called implicitly by the `for_each_XXX()` functions.
+        void freeze();
+
+        bool is_frozen() const STANDARDESE_NOEXCEPT
+        {
+            return frozen_.load(std::memory_order_acquire);
+        }
+
         const doc_entity* try_lookup(const std::string& unique_name) const;
 
         const doc_entity& lookup(const std::string& unique_name) const;
@@ -47,8 +63,9 @@ namespace standardese
         template <typename Func>
         void for_each_file(Func f)
         {
-            for (auto& iter : files_)
-                f(*iter->second.second);
+            freeze();
+            for (auto file : files_)
+                f(*file);
         }
 
         // void(const doc_entity* ns, const doc_entity& member)
@@ -66,6 +83,7 @@ namespace standardese
         template <typename Func>
         void for_each_module(Func f)
         {
+            freeze();
             for (auto& m : modules_)
                 f(m);
         }
@@ -85,10 +103,26 @@ namespace standardese
 
         void namespace_member_impl(ns_member_cb cb, void* data);
 
+        void register_impl(const parser& p, const doc_entity& entity) const;
+
+        const doc_entity* lookup_id(const std::string& id) const;
+
+        struct frozen_entry
+        {
+            cpp_name          id;
+            const doc_entity* entity;
+            bool              short_id;
+        };
+
+        // used during registration, moved into frozen_entities_ by freeze()
+        // the ids are interned in the string table of the parser
         mutable std::mutex mutex_;
-        mutable std::map<std::string, std::pair<bool, const doc_entity*>> entities_;
-        mutable std::vector<decltype(entities_)::const_iterator> files_;
-        mutable std::vector<std::string>                         modules_;
+        mutable std::unordered_map<cpp_name, std::pair<bool, const doc_entity*>> entities_;
+
+        std::vector<frozen_entry>        frozen_entities_; // sorted by id
+        std::vector<const doc_entity*>   files_;           // sorted by id, filled by freeze()
+        mutable std::vector<std::string> modules_;         // sorted by freeze()
+        std::atomic<bool>                frozen_{false};
 
         linker linker_;
     };
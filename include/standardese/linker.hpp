@@ -5,6 +5,7 @@
 #ifndef STANDARDESE_LINKER_HPP_INCLUDED
 #define STANDARDESE_LINKER_HPP_INCLUDED
 
+#include <atomic>
 #include <mutex>
 #include <unordered_map>
 
@@ -34,10 +35,26 @@ namespace standardese
     public:
         void register_entity(const doc_entity& e, std::string output_file) const;
 
+        /// \effects Registers an entity whose anchor id has already been computed,
+        /// e.g. by a previous run.
+        void register_entity(const doc_entity& e, std::string output_file,
+                             std::string anchor_id) const;
+
         std::string register_anchor(const std::string& unique_name, std::string output_file) const;
 
         void change_output_file(const doc_entity& e, std::string output_file) const;
 
+        /// \effects Ends the registration phase, afterwards the locations are read without locking.
+        /// The tables themselves are kept as they are, only the locking stops.
+        /// Entities and anchors must not be registered or changed afterwards,
+        /// this includes processing a template.
+        void freeze();
+
+        bool is_frozen() const STANDARDESE_NOEXCEPT
+        {
+            return frozen_.load(std::memory_order_acquire);
+        }
+
         std::string get_url(const index& idx, const external_linker& external,
                             const doc_entity* context, const std::string& unique_name,
                             const char* extension) const;
@@ -56,6 +73,8 @@ namespace standardese
 
             location(const char* unique_name, std::string output_file);
 
+            location(std::string output_file, std::string id, bool);
+
             std::string format(const char* extension) const;
 
             void set_output_file(std::string output_file);
@@ -71,9 +90,16 @@ namespace standardese
             bool        with_extension_;
         };
 
+        // locks the mutex unless frozen
+        std::unique_lock<std::mutex> lock_reader() const;
+
+        // must be called with the mutex locked, so that freeze() can't happen in between
+        void check_not_frozen() const;
+
         mutable std::mutex mutex_;
         mutable std::unordered_map<const doc_entity*, location> locations_;
         mutable std::unordered_map<std::string, location>       anchors_;
+        std::atomic<bool>                                       frozen_{false};
     };
 } // namespace standardese
 
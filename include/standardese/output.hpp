@@ -187,7 +187,11 @@ namespace standardese
 
     using path = std::string;
 
-    void normalize_urls(const index& idx, md_container& doc,
+    /// \returns Whether or not all entity references were resolved to their final entity.
+    /// This isn't the case if an entity wasn't found, was looked up relative to its context
+    /// or was found through its short id,
+    /// as the result can change when more entities are registered.
+    bool normalize_urls(const index& idx, md_container& doc,
                         const doc_entity* default_context = nullptr);
 
     struct raw_document
@@ -195,6 +199,7 @@ namespace standardese
         path        file_name;
         path        file_extension;
         std::string text;
+        bool complete = true; // whether or not the links don't need to be normalized again
 
         raw_document() = default;
 
@@ -209,6 +214,14 @@ namespace standardese
         {
         }
 
+        /// \returns The rendered document, links to entities are not resolved yet.
+        /// If it is rendered before all entities are registered and it isn't `complete`,
+        /// it must be rendered again afterwards.
+        raw_document get_raw(const md_document& document);
+
+        /// \returns The rendered template for the documentation, links are not resolved yet.
+        raw_document get_raw(const template_file& templ, const documentation& doc);
+
         void render(const std::shared_ptr<spdlog::logger>& logger, const md_document& document,
                     const char* output_extension = nullptr);
 
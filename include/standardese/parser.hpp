@@ -7,6 +7,7 @@
 
 #include <clang-c/Index.h>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -19,6 +20,8 @@
 #include <standardese/cpp_entity_registry.hpp>
 #include <standardese/cpp_preprocessor.hpp>
 #include <standardese/linker.hpp>
+#include <standardese/profiler.hpp>
+#include <standardese/string_table.hpp>
 #include <standardese/template_processor.hpp>
 
 #if CINDEX_VERSION_MAJOR != 0
@@ -60,6 +63,25 @@ namespace standardese
             mutable std::mutex          mutex_;
             mutable file_container_impl impl_;
         };
+
+        // precompiled header shared by all translation units
+        // it is immutable once built, the file is removed when the last user has released it
+        struct preamble
+        {
+            std::string              key;      // compile flags and headers it was built with
+            std::string              pch_file; // empty if it couldn't be built
+            std::vector<std::string> dependencies;
+            unsigned                 build_time; // in ms, also the estimated saving per file
+
+            explicit preamble(std::string key) : key(std::move(key)), build_time(0u)
+            {
+            }
+
+            preamble(const preamble&) = delete;
+            preamble& operator=(const preamble&) = delete;
+
+            ~preamble() STANDARDESE_NOEXCEPT;
+        };
     } // namespace detail
 
     /// Parser class used for parsing the C++ classes.
@@ -78,9 +100,19 @@ namespace standardese
         parser& operator=(const parser&) = delete;
 
         /// Parses a translation unit.
+        /// If the configuration has preamble headers, they are precompiled on the first call
+        /// and the precompiled header is reused for all following calls with the same configuration.
         translation_unit parse(const char* full_path, const compile_config& c,
                                const char* file_name = nullptr) const;
 
+        /// Parses multiple files at once from a single translation unit that includes all of them.
+        /// Code that is shared between the files - e.g. because they include each other - is only parsed once.
+        /// The directives of the files are handled as if the [standardese::preprocessor_backend::in_process]() backend is used.
+        /// \returns The translation units of the files, in the same order.
+        std::vector<translation_unit> parse_unity(const std::vector<std::string>& full_paths,
+                                                  const compile_config&           c,
+                                                  const std::vector<std::string>& file_names = {}) const;
+
         const cpp_entity_registry& get_entity_registry() const STANDARDESE_NOEXCEPT
         {
             return entity_registry_;
@@ -91,6 +123,12 @@ namespace standardese
             return comment_registry_;
         }
 
+        /// \returns The table the names of the parser are interned in.
+        const string_table& get_string_table() const STANDARDESE_NOEXCEPT
+        {
+            return strings_;
+        }
+
         const std::shared_ptr<spdlog::logger>& get_logger() const STANDARDESE_NOEXCEPT
         {
             return logger_;
@@ -151,12 +189,32 @@ namespace standardese
             return index_.get();
         }
 
+        /// \effects Sets the profiler that receives the time spent in the phases of parsing
+        /// and waiting for the locks of the registries,
+        /// `nullptr` disables profiling.
+        /// The profiler must live as long as the parser is used.
+        void set_profiler(profiler* p) STANDARDESE_NOEXCEPT
+        {
+            profiler_ = p;
+            comment_registry_.set_profiler(p);
+            entity_registry_.set_profiler(p);
+        }
+
+        profiler* get_profiler() const STANDARDESE_NOEXCEPT
+        {
+            return profiler_;
+        }
+
     private:
         struct deleter
         {
             void operator()(CXIndex idx) const STANDARDESE_NOEXCEPT;
         };
 
+        // the translation units keep the preamble alive, as they refer to its file
+        std::shared_ptr<const detail::preamble> get_preamble(const compile_config& c) const;
+
+        string_table        strings_;
         comment_registry    comment_registry_;
         cpp_entity_registry entity_registry_;
 
@@ -170,6 +228,10 @@ namespace standardese
         detail::wrapper<CXIndex, deleter> index_;
         std::shared_ptr<spdlog::logger> logger_;
         detail::file_container          files_;
+        profiler*                       profiler_;
+
+        mutable std::mutex                              preamble_mutex_;
+        mutable std::shared_ptr<const detail::preamble> preamble_; // of the last configuration
     };
 } // namespace standardese
 
@@ -0,0 +1,151 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_PROFILER_HPP_INCLUDED
+#define STANDARDESE_PROFILER_HPP_INCLUDED
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <string>
+
+#include <standardese/noexcept.hpp>
+
+namespace standardese
+{
+    /// The phases of processing a file.
+    enum class profile_phase
+    {
+        /// Preprocessing the file, the bytes are the size of the preprocessed source.
+        preprocess,
+        /// Parsing the preprocessed source with libclang.
+        parse,
+        /// Tokenizing the file and parsing the macros and includes.
+        directives,
+        /// Parsing the documentation comments.
+        comments,
+        /// Building the entities of the parsed file.
+        entities,
+        /// Generating the documentation.
+        generate,
+        /// Rendering the documentation, the bytes are the size of the result.
+        render,
+        /// Writing the documentation, the bytes are the number of bytes written.
+        write,
+        /// Waiting for the lock of a shared registry, the file is the name of the registry.
+        /// It isn't a phase of a file, so it is reported separately.
+        lock_wait,
+        count
+    };
+
+    /// \returns The name of the phase.
+    const char* get_phase_name(profile_phase phase) STANDARDESE_NOEXCEPT;
+
+    /// A phase of a file that has been measured.
+    struct profile_event
+    {
+        using clock = std::chrono::steady_clock;
+
+        std::string       file;
+        profile_phase     phase;
+        clock::time_point begin, end;
+        double            cpu_time; // in seconds, of the thread that executed the phase
+        std::size_t       bytes;
+        std::string       detail; // e.g. the output format, empty if not applicable
+    };
+
+    /// Receives the measured phases.
+    /// It is called on the thread that executed the phase and must be thread-safe.
+    class profiler
+    {
+    public:
+        profiler() = default;
+        profiler(const profiler&) = delete;
+        profiler& operator=(const profiler&) = delete;
+        virtual ~profiler() STANDARDESE_NOEXCEPT = default;
+
+        void record(const profile_event& e)
+        {
+            do_record(e);
+        }
+
+    private:
+        virtual void do_record(const profile_event& e) = 0;
+    };
+
+    /// \returns The CPU time in seconds the calling thread has used.
+    double get_thread_cpu_time() STANDARDESE_NOEXCEPT;
+
+    /// Measures a phase from its construction to its destruction.
+    /// It does nothing if there is no profiler.
+    class profile_timer
+    {
+    public:
+        profile_timer(profiler* p, const char* file, profile_phase phase)
+        : profiler_(p), cpu_begin_(p ? get_thread_cpu_time() : 0.0)
+        {
+            if (profiler_)
+            {
+                event_.file  = file;
+                event_.phase = phase;
+                event_.bytes = 0u;
+                event_.begin = profile_event::clock::now();
+            }
+        }
+
+        profile_timer(const profile_timer&) = delete;
+        profile_timer& operator=(const profile_timer&) = delete;
+
+        ~profile_timer() STANDARDESE_NOEXCEPT
+        {
+            if (!profiler_)
+                return;
+
+            event_.end      = profile_event::clock::now();
+            event_.cpu_time = get_thread_cpu_time() - cpu_begin_;
+            try
+            {
+                profiler_->record(event_);
+            }
+            catch (...)
+            {
+                // profiling must not influence the result
+            }
+        }
+
+        void set_bytes(std::size_t bytes) STANDARDESE_NOEXCEPT
+        {
+            event_.bytes = bytes;
+        }
+
+        void set_detail(const char* detail)
+        {
+            if (profiler_)
+                event_.detail = detail;
+        }
+
+    private:
+        profile_event event_;
+        profiler*     profiler_;
+        double        cpu_begin_;
+    };
+
+    /// \effects Locks the mutex.
+    /// If it is already locked, the time spent waiting is measured
+    /// as [standardese::profile_phase::lock_wait]().
+    /// \returns The lock.
+    template <typename Mutex>
+    std::unique_lock<Mutex> lock_profiled(Mutex& m, profiler* p, const char* name)
+    {
+        std::unique_lock<Mutex> lock(m, std::try_to_lock);
+        if (!lock.owns_lock())
+        {
+            profile_timer timer(p, name, profile_phase::lock_wait);
+            lock.lock();
+        }
+        return lock;
+    }
+} // namespace standardese
+
+#endif // STANDARDESE_PROFILER_HPP_INCLUDED
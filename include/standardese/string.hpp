@@ -5,7 +5,10 @@
 #ifndef STANDARDESE_STRING_HPP_INCLUDED
 #define STANDARDESE_STRING_HPP_INCLUDED
 
+#include <atomic>
+#include <cstdint>
 #include <cstring>
+#include <functional>
 #include <new>
 #include <string>
 #include <type_traits>
@@ -16,7 +19,78 @@
 
 namespace standardese
 {
+    namespace detail
+    {
+        // FNV-1a
+        inline std::size_t hash_string(const char* str, std::size_t length) STANDARDESE_NOEXCEPT
+        {
+            std::uint64_t result = 14695981039346656037ull;
+            for (auto end = str + length; str != end; ++str)
+            {
+                result ^= static_cast<unsigned char>(*str);
+                result *= 1099511628211ull;
+            }
+            return static_cast<std::size_t>(result);
+        }
+
+        inline std::size_t hash_string(const char* str) STANDARDESE_NOEXCEPT
+        {
+            return hash_string(str, std::strlen(str));
+        }
+
+        // an immutable, reference counted string with a precomputed hash
+        // the characters are stored directly after the object
+        // atoms of a string_table are unique in it, so they can be compared by address
+        class string_atom
+        {
+        public:
+            // returns a new atom with a reference count of one
+            static const string_atom* create(const char* str, std::size_t length,
+                                             const void* table = nullptr);
+
+            void add_ref() const STANDARDESE_NOEXCEPT
+            {
+                refs_.fetch_add(1u, std::memory_order_relaxed);
+            }
+
+            // destroys the atom when the last reference is released
+            void release() const STANDARDESE_NOEXCEPT;
+
+            const char* c_str() const STANDARDESE_NOEXCEPT
+            {
+                return reinterpret_cast<const char*>(this + 1);
+            }
+
+            std::size_t length() const STANDARDESE_NOEXCEPT
+            {
+                return length_;
+            }
+
+            std::size_t hash() const STANDARDESE_NOEXCEPT
+            {
+                return hash_;
+            }
+
+            // the string_table that owns the atom or nullptr
+            const void* get_table() const STANDARDESE_NOEXCEPT
+            {
+                return table_;
+            }
+
+        private:
+            string_atom(std::size_t length, std::size_t hash, const void* table)
+                STANDARDESE_NOEXCEPT : refs_(1u), length_(length), hash_(hash), table_(table)
+            {
+            }
+
+            mutable std::atomic<std::size_t> refs_;
+            std::size_t                      length_, hash_;
+            const void*                      table_;
+        };
+    } // namespace detail
+
     /// Wrapper around CXString used for safe access.
+    /// Copies of string literals and interned strings are cheap, they share the characters.
     class string
     {
     public:
@@ -30,7 +104,7 @@ namespace standardese
         }
 
         template <std::size_t N>
-        string(const char (&str)[N]) : length_(N), type_(literal)
+        string(const char (&str)[N]) : length_(N - 1u), type_(literal)
         {
             ::new (get_storage()) const char*(str);
         }
@@ -56,9 +130,43 @@ namespace standardese
             }
         }
 
-        string(const string& other) : length_(other.length_), type_(std_string)
+        /// \effects Creates a string that shares the characters of the atom.
+        explicit string(const detail::string_atom& atom) STANDARDESE_NOEXCEPT
+        : length_(atom.length()),
+          type_(interned)
+        {
+            atom.add_ref();
+            ::new (get_storage()) const detail::string_atom*(&atom);
+        }
+
+        /// \returns A string that shares the characters of the atom without owning them,
+        /// the atom must outlive it.
+        /// Copies and moves of it own a reference to the atom, so they can be kept.
+        static string borrow(const detail::string_atom& atom) STANDARDESE_NOEXCEPT
+        {
+            return string(&atom, borrow_t{});
+        }
+
+        string(const string& other) : length_(other.length_), type_(other.type_)
+        {
+            if (type_ == literal)
+                ::new (get_storage()) const char*(other.c_str());
+            else if (type_ == interned || type_ == borrowed)
+            {
+                type_ = interned;
+                other.get_atom()->add_ref();
+                ::new (get_storage()) const detail::string_atom*(other.get_atom());
+            }
+            else
+            {
+                type_ = std_string;
+                ::new (get_storage()) std::string(other.c_str(), other.length_);
+            }
+        }
+
+        string(string&& other) STANDARDESE_NOEXCEPT : length_(other.length_), type_(other.type_)
         {
-            ::new (get_storage()) std::string(other.c_str());
+            steal(other);
         }
 
         ~string() STANDARDESE_NOEXCEPT
@@ -68,25 +176,56 @@ namespace standardese
 
         string& operator=(const string& other)
         {
-            std::string str(other.c_str());
-            if (type_ == std_string)
-                *static_cast<std::string*>(get_storage()) = std::move(str);
-            else
+            string tmp(other);
+            return *this = std::move(tmp);
+        }
+
+        string& operator=(string&& other) STANDARDESE_NOEXCEPT
+        {
+            if (this != &other)
             {
                 free();
-                ::new (get_storage()) std::string(std::move(str));
+                length_ = other.length_;
+                type_   = other.type_;
+                steal(other);
             }
-            length_ = other.length_;
-
             return *this;
         }
 
+        /// \returns A string with the same characters that can be copied cheaply.
+        /// If it isn't interned or a literal already, the characters are copied once.
+        string share() const
+        {
+            if (type_ == literal || type_ == interned || type_ == borrowed)
+                return *this;
+            return string(detail::string_atom::create(c_str(), length_), adopt_t{});
+        }
+
+        /// \returns The atom the characters are shared with or `nullptr` if there is none.
+        const detail::string_atom* get_atom() const STANDARDESE_NOEXCEPT
+        {
+            if (type_ != interned && type_ != borrowed)
+                return nullptr;
+            return *static_cast<const detail::string_atom* const*>(get_storage());
+        }
+
+        /// \returns The FNV-1a hash of the characters,
+        /// it is only computed once for interned strings.
+        std::size_t hash() const STANDARDESE_NOEXCEPT
+        {
+            if (auto atom = get_atom())
+                return atom->hash();
+            return detail::hash_string(c_str(), length_);
+        }
+
         const char* c_str() const STANDARDESE_NOEXCEPT
         {
             if (type_ == std_string)
                 return static_cast<const std::string*>(get_storage())->c_str();
             else if (type_ == literal)
                 return *static_cast<const char* const*>(get_storage());
+            else if (type_ == interned || type_ == borrowed)
+                return get_atom()->c_str();
             return clang_getCString(*static_cast<const CXString*>(get_storage()));
         }
 
@@ -116,6 +255,59 @@ namespace standardese
         }
 
     private:
+        struct adopt_t
+        {
+        };
+
+        struct borrow_t
+        {
+        };
+
+        // doesn't take a reference to the atom
+        string(const detail::string_atom* atom, borrow_t) STANDARDESE_NOEXCEPT
+        : length_(atom->length()),
+          type_(borrowed)
+        {
+            ::new (get_storage()) const detail::string_atom*(atom);
+        }
+
+        // takes ownership of the reference to the atom
+        string(const detail::string_atom* atom, adopt_t) STANDARDESE_NOEXCEPT
+        : length_(atom->length()),
+          type_(interned)
+        {
+            ::new (get_storage()) const detail::string_atom*(atom);
+        }
+
+        // moves the storage of other into this string, length and type are already set
+        void steal(string& other) STANDARDESE_NOEXCEPT
+        {
+            if (type_ == std_string)
+                ::new (get_storage())
+                    std::string(std::move(*static_cast<std::string*>(other.get_storage())));
+            else if (type_ == cx_string)
+                ::new (get_storage()) CXString(*static_cast<CXString*>(other.get_storage()));
+            else if (type_ == interned)
+                ::new (get_storage()) const detail::string_atom*(other.get_atom());
+            else if (type_ == borrowed)
+            {
+                // the moved string may outlive the atom
+                type_ = interned;
+                other.get_atom()->add_ref();
+                ::new (get_storage()) const detail::string_atom*(other.get_atom());
+            }
+            else
+                ::new (get_storage()) const char*(other.c_str());
+
+            if (type_ == cx_string || type_ == interned)
+            {
+                // other must not release it anymore
+                other.type_ = literal;
+                ::new (other.get_storage()) const char*("");
+            }
+            other.length_ = 0u;
+        }
+
         void* get_storage() STANDARDESE_NOEXCEPT
         {
             return static_cast<void*>(&storage_);
@@ -132,6 +324,8 @@ namespace standardese
                 clang_disposeString(*static_cast<CXString*>(get_storage()));
             else if (type_ == std_string)
                 static_cast<std::string*>(get_storage())->~basic_string();
+            else if (type_ == interned)
+                get_atom()->release();
         }
 
         std::aligned_storage<(sizeof(std::string) > sizeof(CXString)) ? sizeof(std::string) :
@@ -143,11 +337,25 @@ namespace standardese
             cx_string,
             std_string,
             literal,
+            interned,
+            borrowed, // an atom without a reference
         } type_;
     };
 
     inline bool operator==(const string& a, const string& b) STANDARDESE_NOEXCEPT
     {
+        auto atom_a = a.get_atom();
+        auto atom_b = b.get_atom();
+        if (atom_a && atom_b)
+        {
+            if (atom_a == atom_b)
+                return true;
+            else if (atom_a->get_table() && atom_a->get_table() == atom_b->get_table())
+                // atoms of the same table are unique
+                return false;
+            else if (atom_a->hash() != atom_b->hash())
+                return false;
+        }
         return std::strcmp(a.c_str(), b.c_str()) == 0;
     }
 
@@ -197,6 +405,18 @@ namespace standardese
     }
 } // namespace standardese
 
+namespace std
+{
+    template <>
+    struct hash<standardese::string>
+    {
+        std::size_t operator()(const standardese::string& str) const STANDARDESE_NOEXCEPT
+        {
+            return str.hash();
+        }
+    };
+} // namespace std
+
 namespace Catch
 {
     inline std::string toString(const standardese::string& str)
@@ -0,0 +1,71 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_STRING_TABLE_HPP_INCLUDED
+#define STANDARDESE_STRING_TABLE_HPP_INCLUDED
+
+#include <array>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+#include <standardese/noexcept.hpp>
+#include <standardese/string.hpp>
+
+namespace standardese
+{
+    /// A table of interned strings.
+    /// Strings with the same characters that are interned in the same table share them,
+    /// so they can be copied, hashed and compared in constant time.
+    /// It can be used from multiple threads at once.
+    class string_table
+    {
+    public:
+        string_table() = default;
+
+        string_table(const string_table&) = delete;
+
+        /// \effects Releases the strings of the table,
+        /// the interned strings that are still in use stay valid.
+        ~string_table() STANDARDESE_NOEXCEPT;
+
+        string_table& operator=(const string_table&) = delete;
+
+        /// \returns The interned string with the given characters,
+        /// it is created on the first call with these characters.
+        string intern(const char* str, std::size_t length) const;
+
+        string intern(const char* str) const
+        {
+            return intern(str, std::strlen(str));
+        }
+
+        /// \returns The interned string with the same characters,
+        /// the string itself if it is already interned in this table.
+        string intern(const string& str) const;
+
+        /// \returns The number of distinct strings in the table.
+        std::size_t size() const STANDARDESE_NOEXCEPT;
+
+    private:
+        // the atoms are distributed over the shards by their hash,
+        // so that concurrent calls rarely wait for the same mutex
+        struct shard
+        {
+            mutable std::mutex mutex;
+            std::unordered_multimap<std::size_t, const detail::string_atom*> map;
+        };
+
+        static const std::size_t shard_count = 16u;
+
+        shard& get_shard(std::size_t hash) const STANDARDESE_NOEXCEPT
+        {
+            return shards_[hash % shard_count];
+        }
+
+        mutable std::array<shard, shard_count> shards_;
+    };
+} // namespace standardese
+
+#endif // STANDARDESE_STRING_TABLE_HPP_INCLUDED
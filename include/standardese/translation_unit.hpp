@@ -5,15 +5,21 @@
 #ifndef STANDARDESE_TRANSLATION_UNIT_HPP_INCLUDED
 #define STANDARDESE_TRANSLATION_UNIT_HPP_INCLUDED
 
+#include <standardese/detail/raw_comment.hpp>
+#include <standardese/detail/token_buffer.hpp>
 #include <standardese/detail/wrapper.hpp>
 #include <standardese/cpp_entity.hpp>
 #include <standardese/cpp_entity_registry.hpp>
 
 #include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace standardese
 {
     class parser;
+    class preprocessor;
     class compile_config;
     struct cpp_cursor;
 
@@ -30,7 +36,9 @@ namespace standardese
         using tu_wrapper = detail::wrapper<CXTranslationUnit, tu_deleter>;
     } // namespace detail
 
-    class cpp_file : public cpp_entity, public cpp_entity_container<cpp_entity>
+    class cpp_file : private detail::entity_arena_owner,
+                     public cpp_entity,
+                     public cpp_entity_container<cpp_entity>
     {
     public:
         static cpp_entity::type get_entity_type() STANDARDESE_NOEXCEPT
@@ -50,7 +58,32 @@ namespace standardese
 
         CXTranslationUnit get_cxunit() STANDARDESE_NOEXCEPT
         {
-            return wrapper_.get();
+            return unit_ ? unit_->get() : nullptr;
+        }
+
+        /// \effects Releases the libclang translation unit of the file,
+        /// or gives up its share of it if it is shared between the files of a unity parse.
+        /// Afterwards the cursors of the entities are dangling,
+        /// so the entities must not be used except through names that have already been computed,
+        /// their names and presumed locations are computed when the file is parsed.
+        void release_cxunit() STANDARDESE_NOEXCEPT
+        {
+            tokens_ = detail::token_buffer();
+            unit_.reset();
+            preamble_.reset();
+        }
+
+        /// \returns The tokens of the file, shared by the parsers of all entities.
+        /// It is empty if the file hasn't been parsed or the translation unit has been released.
+        const detail::token_buffer& get_tokens() const STANDARDESE_NOEXCEPT
+        {
+            return tokens_;
+        }
+
+        /// \returns The full paths of all files that were included, directly or indirectly.
+        const std::vector<std::string>& get_dependencies() const STANDARDESE_NOEXCEPT
+        {
+            return dependencies_;
         }
 
     private:
@@ -59,10 +92,14 @@ namespace standardese
         {
         }
 
-        cpp_name           path_;
-        detail::tu_wrapper wrapper_;
+        cpp_name                            path_;
+        std::shared_ptr<const void>         preamble_; // the precompiled header, used by the unit
+        std::shared_ptr<detail::tu_wrapper> unit_; // shared between the files of a unity parse
+        detail::token_buffer                tokens_; // destroyed before the unit
+        std::vector<std::string>            dependencies_;
 
         friend parser;
+        friend preprocessor;
     };
 
     class translation_unit
@@ -82,12 +119,25 @@ namespace standardese
 
         const cpp_entity_registry& get_registry() const STANDARDESE_NOEXCEPT;
 
+        /// \returns The memory in bytes used by the libclang translation unit,
+        /// including the buffer of the preprocessed source and the tokens of the file.
+        /// If the translation unit is shared by multiple files, it is the usage of the entire unit.
+        std::size_t get_memory_usage() const;
+
+        /// \returns The documentation comments of the file, as registered in the comment registry.
+        const std::vector<detail::raw_comment>& get_raw_comments() const STANDARDESE_NOEXCEPT
+        {
+            return comments_;
+        }
+
     private:
-        translation_unit(const parser& par, const char* path, cpp_file* file);
+        translation_unit(const parser& par, const char* path, cpp_file* file,
+                         std::vector<detail::raw_comment> comments);
 
-        cpp_name      full_path_;
-        cpp_file*     file_;
-        const parser* parser_;
+        std::vector<detail::raw_comment> comments_;
+        cpp_name                         full_path_;
+        cpp_file*                        file_;
+        const parser*                    parser_;
 
         friend parser;
     };
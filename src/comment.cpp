@@ -4,7 +4,9 @@
 
 #include <standardese/comment.hpp>
 
+#include <algorithm>
 #include <cmark.h>
+#include <iterator>
 #include <stack>
 
 #include <standardese/detail/raw_comment.hpp>
@@ -64,14 +66,6 @@ md_comment::md_comment() : md_container(get_entity_type(), cmark_node_new(CMARK_
     md_container::add_entity(std::move(brief));
 }
 
-bool detail::comment_compare::operator()(const comment_id& id_a,
-                                         const comment_id& id_b) const STANDARDESE_NOEXCEPT
-{
-    if (id_a.file_name_or_name_ != id_b.file_name_or_name_)
-        return id_a.file_name_or_name_ < id_b.file_name_or_name_;
-    return id_a.line_ < id_b.line_;
-}
-
 bool comment::empty() const STANDARDESE_NOEXCEPT
 {
     assert(!get_content().empty()); // always at least brief
@@ -93,6 +87,19 @@ bool comment::empty() const STANDARDESE_NOEXCEPT
     return true;
 }
 
+comment comment::with_content(md_ptr<md_comment> content) const
+{
+    comment result;
+    result.unique_name_override_ = unique_name_override_;
+    result.synopsis_override_    = synopsis_override_;
+    result.module_               = module_;
+    result.group_name_           = group_name_;
+    result.content_              = std::move(content);
+    result.group_id_             = group_id_;
+    result.excluded_             = excluded_;
+    return result;
+}
+
 namespace
 {
     void set_synopsis(std::string& result, const std::string& synopsis, unsigned tab_width)
@@ -202,30 +209,102 @@ string detail::get_unique_name(const doc_entity* parent, const string& unique_na
     return result;
 }
 
+comment_registry::comment_registry()
+: profiler_(nullptr)
+{
+    // the empty maps can be shared, they're never modified
+    auto no_files   = std::make_shared<const file_map>();
+    auto no_names   = std::make_shared<const name_map>();
+    auto no_remotes = std::make_shared<const remote_map>();
+    for (auto& shard : files_)
+        shard = no_files;
+    for (auto& shard : names_)
+        shard = no_names;
+    for (auto& shard : remotes_)
+        shard = no_remotes;
+}
+
 bool comment_registry::register_comment(comment_id id, comment c) const
 {
-    std::unique_lock<std::mutex> lock(mutex_);
-    auto result = comments_.insert(std::make_pair(std::move(id), std::move(c)));
-    return result.second;
+    std::vector<std::pair<comment_id, comment>> comments;
+    comments.emplace_back(std::move(id), std::move(c));
+    return register_comments(std::move(comments)) == 1u;
 }
 
-namespace
+std::size_t comment_registry::register_comments(
+    std::vector<std::pair<comment_id, comment>> comments) const
 {
-    std::pair<string, unsigned> get_location(const cpp_cursor& cur)
+    auto less = [](const location_entry& a, const location_entry& b) {
+        return a.inline_name != b.inline_name ? a.inline_name < b.inline_name : a.line < b.line;
+    };
+    auto equal = [](const location_entry& a, const location_entry& b) {
+        return a.line == b.line && a.inline_name == b.inline_name;
+    };
+
+    // build the new tables without holding the lock
+    std::unordered_map<std::string, file_table>                   new_files;
+    std::vector<std::pair<std::string, std::shared_ptr<comment>>> new_names;
+    for (auto& pair : comments)
     {
-        assert(!clang_Cursor_isNull(cur) && !clang_isTranslationUnit(clang_getCursorKind(cur)));
+        auto& id  = pair.first;
+        auto  ptr = std::make_shared<comment>(std::move(pair.second));
+        if (id.is_name())
+            new_names.emplace_back(id.unique_name().c_str(), std::move(ptr));
+        else
+            new_files[id.file_name().c_str()].push_back(
+                {id.is_inline_location() ? id.inline_entity_name().c_str() : "", id.line(),
+                 std::move(ptr)});
+    }
+    for (auto& file : new_files)
+        std::stable_sort(file.second.begin(), file.second.end(), less);
 
-        // we need the extent because we need the very first character of the cursor
-        auto range    = clang_getCursorExtent(cur);
-        auto location = clang_getRangeStart(range);
+    std::size_t count = 0u;
+    auto        lock  = lock_profiled(write_mutex_, profiler_, "comment_registry");
 
-        CXString file;
-        unsigned line;
-        clang_getPresumedLocation(location, &file, &line, nullptr);
+    // only the shards that are changed are copied
+    std::shared_ptr<file_map> files[shard_count];
+    for (auto& file : new_files)
+    {
+        auto& shard = files[get_shard(file.first)];
+        if (!shard)
+            shard = std::make_shared<file_map>(*std::atomic_load(&files_[get_shard(file.first)]));
+        auto& table = (*shard)[file.first];
+
+        auto merged =
+            table ? std::make_shared<file_table>(*table) : std::make_shared<file_table>();
+        auto old_size = merged->size();
+        // the comments registered before come first, so they are kept on duplicate lines
+        merged->insert(merged->end(), std::make_move_iterator(file.second.begin()),
+                       std::make_move_iterator(file.second.end()));
+        std::stable_sort(merged->begin(), merged->end(), less);
+        merged->erase(std::unique(merged->begin(), merged->end(), equal), merged->end());
+
+        count += merged->size() - old_size;
+        table = std::move(merged);
+    }
 
-        return std::make_pair(file, line);
+    std::shared_ptr<name_map> names[shard_count];
+    for (auto& name : new_names)
+    {
+        auto& shard = names[get_shard(name.first)];
+        if (!shard)
+            shard = std::make_shared<name_map>(*std::atomic_load(&names_[get_shard(name.first)]));
+        count += shard->insert(std::move(name)).second ? 1u : 0u;
     }
 
+    for (auto i = 0u; i != shard_count; ++i)
+    {
+        if (files[i])
+            std::atomic_store(&files_[i], std::shared_ptr<const file_map>(std::move(files[i])));
+        if (names[i])
+            std::atomic_store(&names_[i], std::shared_ptr<const name_map>(std::move(names[i])));
+    }
+
+    return count;
+}
+
+namespace
+{
     const cpp_entity& get_inline_parent(const cpp_entity& e)
     {
         if (e.get_entity_type() == cpp_entity::function_parameter_t)
@@ -290,7 +369,7 @@ namespace
 
         auto& parent    = get_inline_parent(e);
         auto  is_inline = &parent != &e;
-        return create_location_id(e.get_entity_type(), get_location(parent.get_cursor()),
+        return create_location_id(e.get_entity_type(), parent.get_presumed_location(),
                                   is_inline ? get_inline_name(e) : "");
     }
 
@@ -322,51 +401,23 @@ namespace
         return parent_id.line() == e_id.line();
     }
 
-    bool matches(const cpp_entity& e, const comment_id& id)
+    // whether or not a comment at the given line is for the entity with the given location id
+    bool matches(const cpp_entity& e, const comment_id& e_id, const std::string& inline_name,
+                 unsigned line)
     {
-        auto& inline_parent = get_inline_parent(e);
-
-        if (id.is_name())
-            return e.get_unique_name() == id.unique_name();
-        else if (id.is_location() && e.get_entity_type() != cpp_entity::file_t)
-        {
-            if (&inline_parent != &e)
-                // an entity that must have an inline location
-                return false;
-
-            auto e_id = create_location_id(e);
-            if (id.file_name() != e_id.file_name())
-                // wrong file
-                return false;
-            else if (id.line() > e_id.line() + 1)
-                // next comment
-                return false;
-            else if (parent_takes_comment(e, e_id))
-                // parent on the same line, so comment can't be for it
-                return false;
-
-            return e_id.line() == id.line() || e_id.line() + 1 == id.line();
-        }
-        else if (id.is_inline_location())
-        {
-            if (&inline_parent == &e)
-                // not an entity where an inline location makes sense
-                return false;
-
-            auto e_id = create_location_id(e);
-            if (id.file_name() != e_id.file_name())
-                // wrong file
-                return false;
-            else if (id.line() > e_id.line() + 1)
-                // next comment
-                return false;
-
-            return (e_id.line() == id.line() || e_id.line() + 1 == id.line())
-                   && inline_name_matches(e, id.inline_entity_name());
-        }
+        auto is_inline = &get_inline_parent(e) != &e;
+        if (is_inline == inline_name.empty())
+            // an entity that must have an inline location or vice versa
+            return false;
+        else if (line > e_id.line() + 1)
+            // next comment
+            return false;
+        else if (!is_inline && parent_takes_comment(e, e_id))
+            // parent on the same line, so comment can't be for it
+            return false;
 
-        assert(e.get_entity_type() == cpp_entity::file_t);
-        return false;
+        return (e_id.line() == line || e_id.line() + 1 == line)
+               && (!is_inline || inline_name_matches(e, inline_name));
     }
 
     comment_id get_name_id(const doc_entity* parent, const cpp_entity& e, const comment* c)
@@ -374,77 +425,97 @@ namespace
         auto result = detail::get_unique_name(parent, e.get_unique_name(true), c);
         return comment_id(detail::get_id(result.c_str()).c_str());
     }
+}
 
-    template <class Map>
-    const comment* lookup_comment_location(Map& comments, const comment_id& id, const cpp_entity& e,
-                                           const doc_entity* parent)
-    {
-        auto iter = comments.lower_bound(id);
-        if (iter != comments.end())
-        {
-            // first try the next higher one, i.e. end of same line
-            // then try the actual match
-            ++iter;
-            if (iter == comments.end() || !matches(e, iter->first))
-            {
-                --iter;
-                if (!matches(e, iter->first))
-                    return nullptr;
-            }
-
-            if (!iter->second.empty())
-                return &iter->second;
-
-            // this command is only used for commands, look for a remote comment
-            auto& comment = iter->second;
+comment* comment_registry::lookup_location(const cpp_entity& e, const comment_id& id) const
+{
+    std::string file_name = id.file_name().c_str();
+    auto        files     = std::atomic_load(&files_[get_shard(file_name)]);
+    auto        file      = files->find(file_name);
+    if (file == files->end())
+        return nullptr;
+    auto& table = *file->second;
+
+    std::string inline_name = id.is_inline_location() ? id.inline_entity_name().c_str() : "";
+    auto        iter        = std::lower_bound(table.begin(), table.end(), id.line(),
+                                 [&](const location_entry& entry, unsigned line) {
+                                     return entry.inline_name != inline_name ?
+                                                entry.inline_name < inline_name :
+                                                entry.line < line;
+                                 });
+    if (iter == table.end())
+        return nullptr;
 
-            iter = comments.find(get_name_id(parent, e, &comment));
-            if (iter != comments.end())
-                // add remote content
-                comment.set_content(iter->second.get_content().clone());
+    // first try the next higher one, i.e. end of same line
+    // then try the actual match
+    auto next = std::next(iter);
+    if (next != table.end() && matches(e, id, next->inline_name, next->line))
+        return next->c.get();
+    else if (matches(e, id, iter->inline_name, iter->line))
+        return iter->c.get();
+    return nullptr;
+}
 
-            return &comment;
-        }
+comment* comment_registry::lookup_name(const std::string& name) const
+{
+    auto names = std::atomic_load(&names_[get_shard(name)]);
+    auto iter  = names->find(name);
+    return iter == names->end() ? nullptr : iter->second.get();
+}
 
-        return nullptr;
-    }
+const comment* comment_registry::add_remote_content(const comment& c, const cpp_entity& e,
+                                                    const doc_entity* parent) const
+{
+    if (!c.empty())
+        return &c;
+
+    auto merged = std::atomic_load(&remotes_[get_shard(&c)]);
+    auto iter   = merged->find(&c);
+    if (iter != merged->end())
+        return iter->second.get();
+
+    // the comment is only used for commands, look for a remote comment
+    // if there is none yet, it is looked for again on the next lookup
+    auto remote = lookup_name(get_name_id(parent, e, &c).unique_name().c_str());
+    if (!remote || remote->empty())
+        return &c;
+    auto result = std::make_shared<const comment>(c.with_content(remote->get_content().clone()));
+
+    // the first merged comment is kept, so all lookups return the same one
+    auto lock  = lock_profiled(write_mutex_, profiler_, "comment_registry");
+    auto shard = std::make_shared<remote_map>(*std::atomic_load(&remotes_[get_shard(&c)]));
+    auto res   = shard->emplace(&c, std::move(result));
+    if (res.second)
+        std::atomic_store(&remotes_[get_shard(&c)],
+                          std::shared_ptr<const remote_map>(std::move(shard)));
+    return res.first->second.get();
 }
 
 const comment* comment_registry::lookup_comment(const cpp_entity& e, const doc_entity* parent) const
 {
-    std::unique_lock<std::mutex> lock(mutex_);
-
     // first look for comments at the location
     auto location = create_location_id(e);
-    if (auto c = lookup_comment_location(comments_, location, e, parent))
-        return c;
+    auto result   = location.is_name() ? lookup_name(location.unique_name().c_str()) :
+                                       lookup_location(e, location);
+    if (result && location.is_name() && e.get_unique_name() != location.unique_name())
+        result = nullptr;
+    if (result)
+        return add_remote_content(*result, e, parent);
 
     // then for comments with the unique name
-    auto id   = get_name_id(parent, e, nullptr);
-    auto iter = comments_.find(comment_id(id));
-    if (iter != comments_.end())
-        return &iter->second;
+    auto id = get_name_id(parent, e, nullptr);
+    if (auto c = lookup_name(id.unique_name().c_str()))
+        return c;
 
     auto short_id = detail::get_short_id(id.unique_name().c_str());
     if (id.unique_name() == short_id)
         return nullptr;
-    iter = comments_.find(comment_id(short_id));
-    if (iter != comments_.end())
-        return &iter->second;
-
-    return nullptr;
+    return lookup_name(short_id);
 }
 
 const comment* comment_registry::lookup_comment(const std::string& module) const
 {
-    std::unique_lock<std::mutex> lock(mutex_);
-
-    auto id   = comment_id(module);
-    auto iter = comments_.find(id);
-    if (iter != comments_.end())
-        return &iter->second;
-
-    return nullptr;
+    return lookup_name(module);
 }
 
 namespace
@@ -493,19 +564,20 @@ namespace
         }
     };
 
-    void register_comment(const parser& p, comment_info& info)
+    // the comments of a file, they are registered at once
+    using comment_batch = std::vector<std::pair<comment_id, comment>>;
+
+    void register_comment(comment_batch& batch, comment_info& info)
     {
-        auto& registry = p.get_comment_registry();
         if (info.inline_comment)
-            registry.register_comment(comment_id(info.file_name, info.end_line,
-                                                 detail::get_id(info.entity_name.c_str())),
-                                      std::move(info.comment));
+            batch.emplace_back(comment_id(info.file_name, info.end_line,
+                                          detail::get_id(info.entity_name.c_str())),
+                               std::move(info.comment));
         else if (!info.entity_name.empty())
-            registry.register_comment(comment_id(detail::get_id(info.entity_name.c_str())),
-                                      std::move(info.comment));
+            batch.emplace_back(comment_id(detail::get_id(info.entity_name.c_str())),
+                               std::move(info.comment));
         else
-            registry.register_comment(comment_id(info.file_name, info.end_line),
-                                      std::move(info.comment));
+            batch.emplace_back(comment_id(info.file_name, info.end_line), std::move(info.comment));
     }
 
     std::string read_command(const parser& p, const md_entity& e)
@@ -588,7 +660,7 @@ namespace
     class container_stack
     {
     public:
-        explicit container_stack(const parser& p, comment_info& info) : info_(&info), parser_(&p)
+        container_stack(comment_batch& batch, comment_info& info) : info_(&info), batch_(&batch)
         {
         }
 
@@ -694,7 +766,7 @@ namespace
             {
                 while (inline_depth_ != 0u)
                     pop();
-                register_comment(*parser_, *cur_inline_);
+                register_comment(*batch_, *cur_inline_);
             }
             cur_inline_.reset(nullptr);
         }
@@ -733,7 +805,7 @@ namespace
         std::stack<container>         stack_;
         std::unique_ptr<comment_info> cur_inline_; // that's a lazy optional emulation, right there
         comment_info*                 info_;
-        const parser*                 parser_;
+        comment_batch*                batch_;
         unsigned                      inline_depth_ = 0;
     };
 
@@ -933,7 +1005,8 @@ namespace
         return false;
     }
 
-    void parse_comment(const parser& p, comment_info& info, const md_node& root)
+    void parse_comment(const parser& p, comment_batch& batch, comment_info& info,
+                       const md_node& root)
     {
         struct iter_deleter
         {
@@ -946,7 +1019,7 @@ namespace
         using md_iter = detail::wrapper<cmark_iter*, iter_deleter>;
         md_iter iter(cmark_iter_new(root.get()));
 
-        container_stack stack(p, info);
+        container_stack stack(batch, info);
         auto            first_content = true;
         for (auto ev = CMARK_EVENT_NONE; (ev = cmark_iter_next(iter.get())) != CMARK_EVENT_DONE;)
         {
@@ -998,19 +1071,26 @@ namespace
             }
         }
 
-        register_comment(p, info);
+        register_comment(batch, info);
     }
 }
 
 void standardese::parse_comments(const parser& p, const char* file_name, const std::string& source)
 {
-    auto raw_comments = detail::read_comments(source);
-    for (auto& raw_comment : raw_comments)
+    parse_comments(p, file_name, detail::read_comments(source));
+}
+
+void standardese::parse_comments(const parser& p, const char* file_name,
+                                 const std::vector<detail::raw_comment>& comments)
+{
+    comment_batch batch;
+    for (auto& raw_comment : comments)
     {
         comment_info info(file_name, raw_comment.end_line - raw_comment.count_lines + 1,
                           raw_comment.end_line);
 
         auto document = parse_document(p, raw_comment.content);
-        parse_comment(p, info, document);
+        parse_comment(p, batch, info, document);
     }
+    p.get_comment_registry().register_comments(std::move(batch));
 }
@@ -140,7 +140,8 @@ namespace
 
 compile_config::compile_config(cpp_standard standard, string commands_dir)
 : flags_{"-x", "c++", "-I", unquote(STANDARDESE_DETAIL_STRINGIFY(LIBCLANG_SYSTEM_INCLUDE_DIR))},
-  clang_binary_(get_clang_binary_default())
+  clang_binary_(get_clang_binary_default()),
+  backend_(preprocessor_backend::external)
 {
     (void)standards_initializer;
 
@@ -175,6 +176,15 @@ void compile_config::add_include(string path)
     flags_.push_back(std::move(path));
 }
 
+void compile_config::add_preamble_header(std::string header)
+{
+    if (header.empty())
+        return;
+    else if (header.front() != '<' && header.front() != '"')
+        header = '<' + header + '>';
+    preamble_.push_back(std::move(header));
+}
+
 void compile_config::set_flag(compile_flag f)
 {
     auto str = flags[int(f)];
@@ -128,7 +128,26 @@ cpp_entity_ptr cpp_entity::try_parse(translation_unit& tu, cpp_cursor cur, const
 
 cpp_name cpp_entity::get_name() const
 {
-    return detail::parse_name(cursor_);
+    return name_.get([&] { return detail::parse_name(cursor_); });
+}
+
+std::pair<cpp_name, unsigned> cpp_entity::get_presumed_location() const
+{
+    auto file = location_file_.get([&] {
+        assert(!clang_Cursor_isNull(cursor_)
+               && !clang_isTranslationUnit(clang_getCursorKind(cursor_)));
+
+        // we need the extent because we need the very first character of the cursor
+        auto range    = clang_getCursorExtent(cursor_);
+        auto location = clang_getRangeStart(range);
+
+        CXString name;
+        unsigned line;
+        clang_getPresumedLocation(location, &name, &line, nullptr);
+        location_line_.store(line, std::memory_order_relaxed);
+        return cpp_name(name);
+    });
+    return std::make_pair(file, location_line_.load(std::memory_order_relaxed));
 }
 
 namespace
@@ -155,8 +174,10 @@ cpp_name cpp_entity::get_scope() const
 cpp_name cpp_entity::get_unique_name(bool exclude_scope) const
 {
     if (exclude_scope)
-        return do_get_unique_name();
-    return get_scope_impl(*this, true) + do_get_unique_name().c_str();
+        return unique_name_.get([&] { return do_get_unique_name(); });
+    return scoped_unique_name_.get([&]() -> cpp_name {
+        return get_scope_impl(*this, true) + get_unique_name(true).c_str();
+    });
 }
 
 cpp_name cpp_entity::do_get_unique_name() const
@@ -170,11 +191,11 @@ cpp_name cpp_entity::do_get_unique_name() const
 }
 
 cpp_entity::cpp_entity(type t, cpp_cursor cur, const cpp_entity& parent)
-: cursor_(cur), next_(nullptr), parent_(&parent), t_(t)
+: location_line_(0u), cursor_(cur), next_(nullptr), parent_(&parent), t_(t)
 {
 }
 
 cpp_entity::cpp_entity(type t, cpp_cursor cur)
-: cursor_(cur), next_(nullptr), parent_(nullptr), t_(t)
+: location_line_(0u), cursor_(cur), next_(nullptr), parent_(nullptr), t_(t)
 {
 }
\ No newline at end of file
@@ -34,21 +34,14 @@ entity_blacklist::entity_blacklist()
 
 namespace
 {
-    bool is_blacklisted(const std::set<std::pair<cpp_name, cpp_entity::type>>& blacklist,
-                        const cpp_name& name, cpp_entity::type t)
+    template <typename Map>
+    bool is_blacklisted(const Map& blacklist, const cpp_name& name, cpp_entity::type t)
     {
-        // set is firsted sorted by name, then type
-        // so this is the first pair with the name
-        static_assert(int(cpp_entity::file_t) == 0, "file must come first");
-        auto first = std::make_pair(name, cpp_entity::file_t);
-
-        auto iter = blacklist.lower_bound(first);
-        if (iter == blacklist.end() || iter->first != name)
-            // no element with this name found
+        if (blacklist.empty())
             return false;
 
-        // iterate until name doesn't match any more
-        for (; iter != blacklist.end() && iter->first == name; ++iter)
+        auto range = blacklist.equal_range(name);
+        for (auto iter = range.first; iter != range.second; ++iter)
             if (iter->second == cpp_entity::invalid_t)
                 // match all
                 return true;
@@ -0,0 +1,58 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include <standardese/cpp_entity_registry.hpp>
+
+#include <cstring>
+
+using namespace standardese;
+
+const std::size_t cpp_entity_registry::shard_count;
+
+void cpp_entity_registry::register_entity(const cpp_entity& e) const
+{
+    string usr(clang_getCursorUSR(e.get_cursor()));
+    if (usr.empty())
+        return;
+
+    auto  hash  = usr.hash();
+    auto& shard = get_shard(hash);
+
+    auto lock  = lock_profiled(shard.mutex, profiler_, "cpp_entity_registry");
+    auto range = shard.map.equal_range(hash);
+    for (auto iter = range.first; iter != range.second; ++iter)
+        if (iter->second.usr == usr)
+            return;
+    shard.map.emplace(hash, entry{usr.share(), &e});
+}
+
+const cpp_entity* cpp_entity_registry::try_lookup(const cpp_cursor& cur) const STANDARDESE_NOEXCEPT
+{
+    // clang_getCursorUSR() allocates the USR, there is no way around that,
+    // but it is only hashed and compared in place, never copied
+    string usr(clang_getCursorUSR(cur));
+    if (usr.empty())
+        return nullptr;
+
+    auto  hash  = usr.hash();
+    auto& shard = get_shard(hash);
+
+    auto lock  = lock_profiled(shard.mutex, profiler_, "cpp_entity_registry");
+    auto range = shard.map.equal_range(hash);
+    for (auto iter = range.first; iter != range.second; ++iter)
+        if (std::strcmp(iter->second.usr.c_str(), usr.c_str()) == 0)
+            return iter->second.entity;
+    return nullptr;
+}
+
+std::size_t cpp_entity_registry::size() const STANDARDESE_NOEXCEPT
+{
+    std::size_t result = 0u;
+    for (auto& shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        result += shard.map.size();
+    }
+    return result;
+}
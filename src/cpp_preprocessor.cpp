@@ -4,6 +4,12 @@
 
 #include <standardese/cpp_preprocessor.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <unordered_set>
+
 #include <boost/config.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/version.hpp>
@@ -16,6 +22,8 @@
 #warning "Boost less than 1.55 isn't tested"
 #endif
 
+#include <standardese/detail/char_scan.hpp>
+#include <standardese/detail/friend_rewriter.hpp>
 #include <standardese/detail/tokenizer.hpp>
 #include <standardese/config.hpp>
 #include <standardese/error.hpp>
@@ -54,12 +62,11 @@ namespace
     }
 }
 
-cpp_ptr<standardese::cpp_macro_definition> cpp_macro_definition::parse(CXTranslationUnit tu,
-                                                                       CXFile file, cpp_cursor cur,
-                                                                       const cpp_entity& parent,
-                                                                       unsigned          line_no)
+cpp_ptr<standardese::cpp_macro_definition> cpp_macro_definition::parse(
+    CXTranslationUnit tu, CXFile file, cpp_cursor cur, const cpp_entity& parent, unsigned line_no,
+    const detail::token_buffer* buffer)
 {
-    detail::tokenizer tokenizer(tu, file, cur);
+    detail::tokenizer tokenizer(tu, file, cur, buffer);
 
     std::string name = tokenizer.begin()[0].get_value().c_str();
     if (is_guard(name))
@@ -110,9 +117,10 @@ namespace
     {
         // -E: print preprocessor output
         // -C: keep comments
+        // -dD: keep macro definitions, so they are part of the translation unit
         // -Wno-pragma-once-outside-header: hide wrong warning
         std::string cmd(fs::path(c.get_clang_binary()).generic_string()
-                        + " -E -CC -Wno-pragma-once-outside-header ");
+                        + " -E -CC -dD -Wno-pragma-once-outside-header ");
         for (auto& flag : c)
         {
             cmd += '"' + std::string(flag.c_str()) + '"';
@@ -131,10 +139,13 @@ namespace
         auto    cmd = get_command(c, full_path);
         Process process(cmd, "",
                         [&](const char* str, std::size_t n) {
-                            preprocessed.reserve(preprocessed.size() + n);
-                            for (auto end = str + n; str != end; ++str)
-                                if (*str != '\r')
-                                    preprocessed.push_back(*str);
+                            // append everything between the '\r's at once
+                            for (auto end = str + n; str != end;)
+                            {
+                                auto cr = detail::find_char(str, end, '\r');
+                                preprocessed.append(str, cr);
+                                str = cr == end ? end : cr + 1;
+                            }
                         },
                         [&](const char* str, std::size_t n) {
                             p.get_logger()->error("[preprocessor] {}", std::string(str, n));
@@ -156,13 +167,30 @@ namespace
             system    = 4, // flag 3
         };
 
-        std::string file_name;
+        const char* file_name; // points into the preprocessed source, not null-terminated
+        std::size_t file_name_length;
         unsigned    line, flags;
 
-        line_marker() : line(0u), flags(0u)
+        line_marker() : file_name(""), file_name_length(0u), line(0u), flags(0u)
         {
         }
 
+        std::string get_file_name() const
+        {
+            return std::string(file_name, file_name_length);
+        }
+
+        bool is_file(const char* name, std::size_t length) const
+        {
+            return file_name_length == length && std::memcmp(file_name, name, length) == 0;
+        }
+
+        // whether it is <built-in> or <command line>
+        bool is_builtin() const
+        {
+            return is_file("<built-in>", 10u) || is_file("<command line>", 14u);
+        }
+
         void set_flag(flag_t f)
         {
             flags |= f;
@@ -185,7 +213,8 @@ namespace
     // flag 2 - returning to previous file
     // flag 3 - system header
     // flag 4 is irrelevant
-    line_marker parse_line_marker(const char*& ptr)
+    // ptr will point to the newline at the end of the marker
+    line_marker parse_line_marker(const char*& ptr, const char* end)
     {
         line_marker result;
 
@@ -195,10 +224,8 @@ namespace
         while (*ptr == ' ')
             ++ptr;
 
-        std::string line;
-        while (std::isdigit(*ptr))
-            line += *ptr++;
-        result.line = unsigned(std::stoi(line));
+        for (; std::isdigit(static_cast<unsigned char>(*ptr)); ++ptr)
+            result.line = result.line * 10u + unsigned(*ptr - '0');
 
         while (*ptr == ' ')
             ++ptr;
@@ -206,20 +233,12 @@ namespace
         assert(*ptr == '"');
         ++ptr;
 
-        std::string file_name;
-        while (*ptr != '"')
-            file_name += *ptr++;
-        ++ptr;
-        result.file_name = std::move(file_name);
-
-        while (*ptr == ' ')
-            ++ptr;
-
-        while (*ptr != '\n')
-        {
-            if (*ptr == ' ')
-                ++ptr;
+        auto file_name_end      = detail::find_char(ptr, end, '"');
+        result.file_name        = ptr;
+        result.file_name_length = std::size_t(file_name_end - ptr);
+        ptr                     = file_name_end == end ? end : file_name_end + 1;
 
+        for (; ptr != end && *ptr != '\n'; ++ptr)
             switch (*ptr)
             {
             case '1':
@@ -231,161 +250,338 @@ namespace
             case '3':
                 result.set_flag(line_marker::system);
                 break;
+            case ' ':
             case '4':
                 break;
             default:
                 assert(false);
             }
-            ++ptr;
-        }
 
         return result;
     }
 
-    CXTranslationUnit get_cxunit(CXIndex index, const compile_config& c, const char* full_path)
-    {
-        auto args = c.get_flags();
-
-        CXTranslationUnit tu;
-        auto              error =
-            clang_parseTranslationUnit2(index, full_path, args.data(),
-                                        static_cast<int>(args.size()), nullptr, 0,
-                                        CXTranslationUnit_Incomplete
-                                            | CXTranslationUnit_DetailedPreprocessingRecord,
-                                        &tu);
-        if (error != CXError_Success)
-            throw libclang_error(error, "CXTranslationUnit (" + std::string(full_path) + ")");
-        return tu;
-    }
-
-    void add_macros(const parser& p, const compile_config& c, const char* full_path, cpp_file& file,
-                    const std::vector<unsigned>& fake_lines)
+    // the translation unit is parsed from the preprocessed source,
+    // so the line numbers already include the fake lines
+    void add_macros(CXTranslationUnit tu, const char* full_path, cpp_file& file)
     {
-        detail::tu_wrapper tu(get_cxunit(p.get_cxindex(), c, full_path));
-        auto               cxfile = clang_getFile(tu.get(), full_path);
-        auto               iter   = fake_lines.begin();
+        auto cxfile = clang_getFile(tu, full_path);
 
-        detail::visit_tu(tu.get(), full_path, [&](cpp_cursor cur, cpp_cursor) {
+        detail::visit_tu(tu, full_path, [&](cpp_cursor cur, cpp_cursor) {
             if (clang_getCursorKind(cur) == CXCursor_MacroDefinition)
             {
                 auto     loc = clang_getCursorLocation(cur);
                 unsigned line;
                 clang_getSpellingLocation(loc, nullptr, &line, nullptr, nullptr);
 
-                iter = std::lower_bound(iter, fake_lines.end(), line);
-                file.add_entity(cpp_macro_definition::parse(tu.get(), cxfile, cur, file,
-                                                            (iter - fake_lines.begin()) + line));
+                file.add_entity(cpp_macro_definition::parse(tu, cxfile, cur, file, line,
+                                                            &file.get_tokens()));
+            }
+            return CXChildVisit_Continue;
+        });
+    }
+
+    std::string read_source(const char* full_path)
+    {
+        std::ifstream file(full_path, std::ios_base::binary);
+        if (!file.is_open())
+            throw std::runtime_error(fmt::format("unable to open file '{}'", full_path));
+
+        file.seekg(0, std::ios_base::end);
+        auto size = file.tellg();
+        file.seekg(0, std::ios_base::beg);
+        if (size < 0)
+            throw std::runtime_error(fmt::format("unable to read file '{}'", full_path));
+
+        std::string source(std::size_t(size), '\0');
+        file.read(&source[0], size);
+        source.resize(std::size_t(file.gcount()));
+        source.erase(std::remove(source.begin(), source.end(), '\r'), source.end());
+        // like the output of the external preprocessor, the source ends with a newline
+        if (source.empty() || source.back() != '\n')
+            source += '\n';
+
+        detail::rewrite_friend_definitions(source);
+        return source;
+    }
+
+    struct inclusion
+    {
+        std::string file_name;
+        unsigned    line;
+        bool        system;
+    };
+
+    // adds all files that were included to the dependencies
+    void add_dependencies(CXTranslationUnit tu, std::vector<std::string>& dependencies)
+    {
+        using data_t = std::pair<std::vector<std::string>*, std::unordered_set<std::string>*>;
+
+        std::unordered_set<std::string> seen(dependencies.begin(), dependencies.end());
+        data_t                          data(&dependencies, &seen);
+
+        clang_getInclusions(tu,
+                            [](CXFile included, CXSourceLocation*, unsigned depth,
+                               CXClientData client_data) {
+                                if (depth == 0u)
+                                    // main file
+                                    return;
+
+                                auto data      = static_cast<data_t*>(client_data);
+                                auto file_name = string(clang_getFileName(included));
+                                if (data->second->insert(file_name.c_str()).second)
+                                    data->first->push_back(file_name.c_str());
+                            },
+                            &data);
+    }
+
+    // returns the files directly included by the main file, in order
+    // uses the inclusion directives instead of clang_getInclusions(),
+    // as those also report headers that were skipped because they are part of a precompiled preamble
+    std::vector<inclusion> get_inclusions(CXTranslationUnit tu, const char* full_path)
+    {
+        std::vector<inclusion> result;
+        detail::visit_tu(tu, full_path, [&](cpp_cursor cur, cpp_cursor) {
+            if (clang_getCursorKind(cur) == CXCursor_InclusionDirective)
+            {
+                auto included = clang_getIncludedFile(cur);
+                if (!included)
+                    // file not found
+                    return CXChildVisit_Continue;
+
+                unsigned line;
+                clang_getSpellingLocation(clang_getCursorLocation(cur), nullptr, &line, nullptr,
+                                          nullptr);
+                auto system = clang_Location_isInSystemHeader(
+                                  clang_getLocationForOffset(tu, included, 0u))
+                              != 0;
+                result.push_back({string(clang_getFileName(included)).c_str(), line, system});
             }
             return CXChildVisit_Continue;
         });
+        return result;
+    }
+
+    // replaces the skipped preprocessor blocks with empty lines
+    void erase_skipped_ranges(CXTranslationUnit tu, const char* full_path, std::string& source)
+    {
+        auto ranges = clang_getSkippedRanges(tu, clang_getFile(tu, full_path));
+        if (!ranges)
+            return;
+
+        std::vector<std::pair<unsigned, unsigned>> lines;
+        for (auto i = 0u; i != ranges->count; ++i)
+        {
+            unsigned begin, end;
+            clang_getSpellingLocation(clang_getRangeStart(ranges->ranges[i]), nullptr, &begin,
+                                      nullptr, nullptr);
+            clang_getSpellingLocation(clang_getRangeEnd(ranges->ranges[i]), nullptr, &end, nullptr,
+                                      nullptr);
+            lines.emplace_back(begin, end);
+        }
+        clang_disposeSourceRangeList(ranges);
+
+        // the skipped lines are blanked out, the newlines are kept,
+        // so the line numbers of the comments don't change
+        auto line = 1u;
+        auto iter = lines.begin();
+        for (auto& c : source)
+        {
+            while (iter != lines.end() && iter->second < line)
+                ++iter;
+
+            if (c == '\n')
+                ++line;
+            else if (iter != lines.end() && iter->first <= line)
+                c = ' ';
+        }
     }
 }
 
 std::string preprocessor::preprocess(const parser& p, const compile_config& c,
                                      const char* full_path, cpp_file& file) const
 {
-    std::string           preprocessed;
-    std::vector<unsigned> fake_lines;
+    if (c.get_preprocessor_backend() == preprocessor_backend::in_process)
+        // directives are handled after parsing, see process_directives()
+        return read_source(full_path);
+
+    std::string                     preprocessed;
+    std::unordered_set<std::string> dependencies;
+    detail::friend_rewriter         rewriter(preprocessed);
 
     auto full_preprocessed = get_full_preprocess_output(p, c, full_path);
-    auto line_no           = 1u;
-    auto file_depth        = 0;
-    auto was_newl = true, in_c_comment = false, write_char = true;
-    for (auto ptr = full_preprocessed.c_str(); *ptr; ++ptr)
-    {
-        if (*ptr == '\n')
+    auto full_path_length  = std::strlen(full_path);
+
+    // only the characters that can change the state are inspected:
+    // a '/' that starts a comment, a '*' that ends it and a '#' at the beginning of a line,
+    // the characters in between are either skipped, if they belong to an included file,
+    // or appended at once and scanned for friend definitions
+    auto begin = full_preprocessed.c_str();
+    auto end   = begin + full_preprocessed.size();
+
+    auto        line_no      = 1u;
+    auto        file_depth   = 0;
+    auto        in_c_comment = false;
+    const char* directive    = nullptr; // the last directive, e.g. #define or #pragma
+    auto        written      = begin;   // everything of the main file before it is written
+
+    auto write_until = [&](const char* ptr) {
+        if (file_depth == 0)
         {
-            was_newl = true;
+            line_no += unsigned(detail::count_char(written, ptr, '\n'));
+            preprocessed.append(written, ptr);
+            rewriter.rewrite();
         }
-        else if (in_c_comment && ptr[0] == '*' && ptr[1] == '/')
+        written = ptr;
+    };
+
+    for (auto ptr = begin; ptr < end;)
+    {
+        if (in_c_comment)
         {
+            auto comment_end = detail::find_char(ptr, end, '*');
+            if (comment_end == end)
+                break;
+            else if (comment_end[1] != '/')
+            {
+                ptr = comment_end + 1;
+                continue;
+            }
             in_c_comment = false;
-            was_newl     = false;
+
+            // the directive ends at the next newline
+            if (directive && detail::find_char(directive, comment_end, '\n') != comment_end)
+                directive = nullptr;
+
             // add an additional newline
             // this allows using c style doc comments in macros
             // normally macros would all be one line, so each entity gets the same comment
-            if (file_depth == 0)
+            // but don't split a macro definition itself
+            if (file_depth == 0 && !directive)
             {
+                write_until(comment_end);
                 preprocessed += '\n';
-                fake_lines.push_back(line_no);
             }
+
+            // the '/' could start another comment
+            ptr = comment_end + 1;
         }
-        else if (*ptr == '/' && ptr[1] == '*')
-        {
-            in_c_comment = true;
-            was_newl     = false;
-        }
-        else if (was_newl && !in_c_comment && *ptr == '#' && ptr[1] != 'p')
+        else
         {
-            auto marker = parse_line_marker(ptr);
-            assert(*ptr == '\n');
-
-            if (marker.file_name == full_path)
+            ptr = detail::find_first_of(ptr, end, '/', '#');
+            if (ptr == end)
+                break;
+            else if (*ptr == '/')
+            {
+                in_c_comment = ptr[1] == '*';
+                ++ptr;
+            }
+            else if (ptr != begin && ptr[-1] != '\n')
+                // not a directive
+                ++ptr;
+            else if (ptr[1] != ' ' || !std::isdigit(static_cast<unsigned char>(ptr[2])))
             {
-                assert(file_depth <= 1);
-                file_depth = 0;
-                write_char = false;
+                // other directive, e.g. #define or #pragma
+                directive = ptr;
+                ++ptr;
+            }
+            else
+            {
+                write_until(ptr);
 
-                if (marker.none_set())
+                auto marker = parse_line_marker(ptr, end);
+                assert(ptr == end || *ptr == '\n');
+
+                // the newline of the marker is written, unless it is a marker of the main file
+                written = ptr;
+                if (marker.is_file(full_path, full_path_length))
                 {
-                    if (line_no < marker.line)
+                    assert(file_depth <= 1);
+                    file_depth = 0;
+                    if (ptr != end)
+                        ++written;
+
+                    if (marker.none_set())
                     {
-                        auto diff = marker.line - line_no;
-                        preprocessed.append(diff, '\n');
+                        if (line_no < marker.line)
+                        {
+                            auto diff = marker.line - line_no;
+                            preprocessed.append(diff, '\n');
+                        }
+                        line_no = marker.line;
                     }
-                    line_no = marker.line;
                 }
-            }
-            else if (marker.is_set(line_marker::enter_new))
-            {
-                ++file_depth;
-                if (file_depth == 1 && marker.file_name != "<built-in>"
-                    && marker.file_name != "<command line>")
+                else if (marker.is_set(line_marker::enter_new))
                 {
-                    // write include
-                    preprocessed += "#include ";
-                    if (marker.is_set(line_marker::system))
-                        preprocessed += '<';
-                    else
-                        preprocessed += '"';
-                    preprocessed += marker.file_name;
-                    if (marker.is_set(line_marker::system))
-                        preprocessed += '>';
-                    else
-                        preprocessed += '"';
-                    preprocessed += '\n';
-                    ++line_no;
-
-                    // also add include
-                    if (is_whitelisted_directory(marker.file_name))
-                        file.add_entity(
-                            cpp_inclusion_directive::make(file, marker.file_name,
-                                                          marker.is_set(line_marker::system) ?
-                                                              cpp_inclusion_directive::system :
-                                                              cpp_inclusion_directive::local,
-                                                          marker.line));
+                    auto file_name = marker.get_file_name();
+                    if (!marker.is_builtin() && dependencies.insert(file_name).second)
+                        file.dependencies_.push_back(file_name);
+
+                    ++file_depth;
+                    if (file_depth == 1 && !marker.is_builtin())
+                    {
+                        // write include
+                        preprocessed += "#include ";
+                        if (marker.is_set(line_marker::system))
+                            preprocessed += '<';
+                        else
+                            preprocessed += '"';
+                        preprocessed += file_name;
+                        if (marker.is_set(line_marker::system))
+                            preprocessed += '>';
+                        else
+                            preprocessed += '"';
+                        preprocessed += '\n';
+                        ++line_no;
+
+                        // also add include
+                        if (is_whitelisted_directory(file_name))
+                            file.add_entity(
+                                cpp_inclusion_directive::make(file, file_name,
+                                                              marker.is_set(line_marker::system) ?
+                                                                  cpp_inclusion_directive::system :
+                                                                  cpp_inclusion_directive::local,
+                                                              marker.line));
+                    }
                 }
-            }
-            else if (marker.is_set(line_marker::enter_old))
-            {
-                --file_depth;
+                else if (marker.is_set(line_marker::enter_old))
+                {
+                    --file_depth;
+                }
+
+                if (ptr != end)
+                    ++ptr;
             }
         }
-        else
-            was_newl = false;
+    }
+    write_until(end);
+    rewriter.finish();
+
+    return preprocessed;
+}
 
-        if (file_depth == 0 && write_char)
+void preprocessor::process_directives(const parser&, const compile_config& c,
+                                      CXTranslationUnit tu, const char* full_path, cpp_file& file,
+                                      std::string& source) const
+{
+    auto in_process = c.get_preprocessor_backend() == preprocessor_backend::in_process;
+    if (in_process)
+    {
+        add_dependencies(tu, file.dependencies_);
+        for (auto& inc : get_inclusions(tu, full_path))
         {
-            preprocessed += *ptr;
-            if (*ptr == '\n')
-                ++line_no;
+            if (is_whitelisted_directory(inc.file_name))
+                file.add_entity(cpp_inclusion_directive::make(file, std::move(inc.file_name),
+                                                              inc.system ?
+                                                                  cpp_inclusion_directive::system :
+                                                                  cpp_inclusion_directive::local,
+                                                              inc.line));
         }
-        else if (file_depth == 0)
-            write_char = true;
     }
 
-    add_macros(p, c, full_path, file, fake_lines);
-    return preprocessed;
+    add_macros(tu, full_path, file);
+
+    if (in_process)
+        erase_skipped_ranges(tu, full_path, source);
 }
 
 void preprocessor::whitelist_include_dir(std::string dir)
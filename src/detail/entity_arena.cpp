@@ -0,0 +1,94 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include <standardese/detail/entity_arena.hpp>
+
+#include <new>
+
+using namespace standardese;
+
+namespace
+{
+    // every entity starts with a header,
+    // it is as big as the alignment, so the entity itself is aligned as well
+    struct alignas(std::max_align_t) entity_header
+    {
+        bool in_arena;
+    };
+
+    const std::size_t alignment  = alignof(std::max_align_t);
+    const std::size_t block_size = 64u * 1024u;
+
+    std::size_t align(std::size_t size) STANDARDESE_NOEXCEPT
+    {
+        return (size + alignment - 1u) & ~(alignment - 1u);
+    }
+}
+
+struct detail::entity_arena::block
+{
+    block*      next;
+    std::size_t size;
+};
+
+detail::entity_arena::~entity_arena() STANDARDESE_NOEXCEPT
+{
+    while (blocks_)
+    {
+        auto next = blocks_->next;
+        ::operator delete(blocks_);
+        blocks_ = next;
+    }
+}
+
+void* detail::entity_arena::allocate(std::size_t size)
+{
+    size = align(size);
+    if (std::size_t(end_ - cur_) < size)
+    {
+        // big entities get a block of their own, so the rest of the current one isn't wasted
+        auto own_block = size > block_size / 4u;
+        auto data_size = own_block ? size : block_size;
+
+        auto header_size = align(sizeof(block));
+        auto memory      = static_cast<char*>(::operator new(header_size + data_size));
+        auto new_block   = ::new (memory) block{nullptr, header_size + data_size};
+        usage_ += new_block->size;
+
+        if (own_block && blocks_)
+        {
+            // keep bumping in the current block
+            new_block->next = blocks_->next;
+            blocks_->next   = new_block;
+            return memory + header_size;
+        }
+
+        new_block->next = blocks_;
+        blocks_         = new_block;
+        cur_            = memory + header_size;
+        end_            = cur_ + data_size;
+    }
+
+    auto result = cur_;
+    cur_ += size;
+    return result;
+}
+
+void* detail::allocate_entity(entity_arena* arena, std::size_t size)
+{
+    auto memory = arena ? arena->allocate(sizeof(entity_header) + size) :
+                          ::operator new(sizeof(entity_header) + size);
+    auto header = ::new (memory) entity_header{arena != nullptr};
+    return header + 1;
+}
+
+void detail::deallocate_entity(void* ptr) STANDARDESE_NOEXCEPT
+{
+    if (!ptr)
+        return;
+
+    auto header = static_cast<entity_header*>(ptr) - 1;
+    if (!header->in_arena)
+        ::operator delete(header);
+}
@@ -0,0 +1,211 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include <standardese/detail/friend_rewriter.hpp>
+
+#include <cassert>
+#include <cctype>
+#include <cstring>
+
+#include <standardese/detail/char_scan.hpp>
+
+using namespace standardese;
+
+namespace
+{
+    const char        keyword[]      = "friend";
+    const std::size_t keyword_length = 6u;
+    const char        prefix[]       = "__standardese_";
+    const std::size_t prefix_length  = 14u;
+
+    // a candidate is only handled once the characters after it are there:
+    // the rest of the keyword and the character after it
+    const std::ptrdiff_t lookahead = keyword_length + 1u;
+
+    // the characters that can change the state of the scanner
+    const char code_chars[]    = "/\"'f";
+    const char pending_chars[] = "/\"'f(){;";
+    const char string_chars[]  = "\"\\\n";
+    const char char_chars[]    = "'\\\n";
+
+    bool is_identifier_char(char c)
+    {
+        // the bytes of UTF-8 sequences are treated as part of an identifier
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_'
+               || static_cast<unsigned char>(c) >= 0x80;
+    }
+
+    // returns the first of the characters in [begin, end) or end
+    template <std::size_t N>
+    const char* find_any(const char* begin, const char* end, const char (&chars)[N])
+    {
+        for (; begin + detail::char_block::size <= end; begin += detail::char_block::size)
+        {
+            detail::char_block block(begin);
+
+            std::uint32_t mask = 0u;
+            for (auto i = 0u; i != N - 1u; ++i)
+                mask |= block.match(chars[i]);
+            if (mask)
+                return begin + detail::count_trailing_zeros(mask);
+        }
+
+        for (; begin < end; ++begin)
+            if (std::memchr(chars, *begin, N - 1u))
+                return begin;
+        return end;
+    }
+
+    bool is_keyword(const char* begin, const char* ptr, const char* end)
+    {
+        return end - ptr >= std::ptrdiff_t(keyword_length)
+               && std::memcmp(ptr, keyword, keyword_length) == 0
+               && (ptr == begin || !is_identifier_char(ptr[-1]))
+               && (ptr + keyword_length == end || !is_identifier_char(ptr[keyword_length]));
+    }
+}
+
+void detail::friend_rewriter::finish()
+{
+    scan(true);
+    if (definitions_.empty())
+        return;
+
+    // the text after each keyword is moved once, beginning at the end
+    auto& source   = *source_;
+    auto  old_size = source.size();
+    source.resize(old_size + definitions_.size() * prefix_length);
+
+    auto data     = &source[0];
+    auto dest     = data + source.size();
+    auto text_end = old_size;
+    for (auto iter = definitions_.rbegin(); iter != definitions_.rend(); ++iter)
+    {
+        auto length = text_end - *iter;
+        dest -= length;
+        std::memmove(dest, data + *iter, length);
+        dest -= prefix_length;
+        std::memcpy(dest, prefix, prefix_length);
+        text_end = *iter;
+    }
+    assert(dest == data + text_end);
+}
+
+void detail::friend_rewriter::scan(bool finish)
+{
+    auto begin = source_->c_str();
+    auto end   = begin + source_->size();
+
+    auto ptr = begin + scanned_;
+    while (ptr < end)
+    {
+        const char* next = end;
+        switch (state_)
+        {
+        case state::code:
+            next = pending_ ? find_any(ptr, end, pending_chars) : find_any(ptr, end, code_chars);
+            break;
+        case state::line_comment:
+            next = find_char(ptr, end, '\n');
+            break;
+        case state::block_comment:
+            next = find_char(ptr, end, '*');
+            break;
+        case state::string_literal:
+            next = find_any(ptr, end, string_chars);
+            break;
+        case state::char_literal:
+            next = find_any(ptr, end, char_chars);
+            break;
+        }
+
+        if (next == end)
+        {
+            ptr = end;
+            break;
+        }
+        else if (!finish && end - next < lookahead)
+        {
+            // continue once more has been appended
+            ptr = next;
+            break;
+        }
+
+        ptr = next + 1;
+        switch (state_)
+        {
+        case state::code:
+            if (*next == '/' && next[1] == '/')
+                state_ = state::line_comment;
+            else if (*next == '/' && next[1] == '*')
+                state_ = state::block_comment;
+            else if (*next == '"')
+                state_ = state::string_literal;
+            else if (*next == '\'')
+            {
+                // a digit separator doesn't start a character literal
+                if (next == begin || !std::isdigit(static_cast<unsigned char>(next[-1])))
+                    state_ = state::char_literal;
+            }
+            else if (*next == 'f')
+            {
+                if (is_keyword(begin, next, end))
+                {
+                    if (!pending_)
+                    {
+                        pending_     = true;
+                        keyword_     = std::size_t(next - begin);
+                        paren_count_ = 0;
+                    }
+                    ptr = next + keyword_length;
+                }
+            }
+            else if (*next == '(')
+                ++paren_count_;
+            else if (*next == ')')
+                --paren_count_;
+            else if (*next == '{')
+            {
+                if (paren_count_ == 0)
+                {
+                    // friend function definition
+                    definitions_.push_back(keyword_);
+                    pending_ = false;
+                }
+            }
+            else if (*next == ';')
+                // other friend, keep
+                pending_ = false;
+
+            if (state_ != state::code)
+                // skip the second character of "//" and "/*"
+                ptr = *next == '/' ? next + 2 : next + 1;
+            break;
+
+        case state::line_comment:
+            state_ = state::code;
+            break;
+
+        case state::block_comment:
+            if (next[1] == '/')
+            {
+                state_ = state::code;
+                ptr    = next + 2;
+            }
+            break;
+
+        case state::string_literal:
+        case state::char_literal:
+            if (*next == '\\')
+                // skip the escaped character
+                ptr = next + 1 == end ? end : next + 2;
+            else
+                // the closing quote or an unterminated literal
+                state_ = state::code;
+            break;
+        }
+    }
+
+    scanned_ = std::size_t(ptr - begin);
+}
@@ -0,0 +1,79 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include <standardese/detail/memoized_name.hpp>
+
+#include <deque>
+#include <mutex>
+
+using namespace standardese;
+
+namespace
+{
+    // only written by its thread, the padding keeps the counters of different threads
+    // on different cache lines
+    struct name_counter
+    {
+        std::atomic<std::size_t> computed, cached;
+        char                     padding[128];
+
+        name_counter() STANDARDESE_NOEXCEPT : computed(0u), cached(0u)
+        {
+        }
+    };
+
+    std::mutex& counters_mutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    // the counters of threads that have exited are kept, so they are still summed up
+    std::deque<name_counter>& counters()
+    {
+        static std::deque<name_counter> counters;
+        return counters;
+    }
+
+    name_counter& thread_counter()
+    {
+        static thread_local name_counter* counter = nullptr;
+        if (!counter)
+        {
+            std::lock_guard<std::mutex> lock(counters_mutex());
+            counters().emplace_back();
+            counter = &counters().back();
+        }
+        return *counter;
+    }
+
+    void increment(std::atomic<std::size_t>& counter) STANDARDESE_NOEXCEPT
+    {
+        // there is only one writer, so it doesn't need an atomic read-modify-write
+        counter.store(counter.load(std::memory_order_relaxed) + 1u, std::memory_order_relaxed);
+    }
+}
+
+detail::name_statistics detail::get_name_statistics() STANDARDESE_NOEXCEPT
+{
+    name_statistics result = {0u, 0u};
+
+    std::lock_guard<std::mutex> lock(counters_mutex());
+    for (auto& counter : counters())
+    {
+        result.computed += counter.computed.load(std::memory_order_relaxed);
+        result.cached += counter.cached.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+void detail::count_computed_name() STANDARDESE_NOEXCEPT
+{
+    increment(thread_counter().computed);
+}
+
+void detail::count_cached_name() STANDARDESE_NOEXCEPT
+{
+    increment(thread_counter().cached);
+}
@@ -7,6 +7,7 @@
 
 #include <cassert>
 #include <cctype>
+#include <cstring>
 
 using namespace standardese;
 
@@ -58,9 +59,9 @@ cpp_name detail::parse_class_name(cpp_cursor cur)
 
 namespace
 {
-    bool both_alpha(const std::string& result, const string& token)
+    bool both_alpha(const std::string& result, const char* token)
     {
-        return std::isalnum(result.back()) && std::isalnum(*token.begin());
+        return std::isalnum(result.back()) && std::isalnum(*token);
     }
 
     bool ends_with(const std::string& result, const char* str)
@@ -72,16 +73,17 @@ namespace
     }
 }
 
-void detail::append_token(std::string& result, const string& token)
+void detail::append_token(std::string& result, const char* token)
 {
     // these are the whitespace rules I've come up with
     // note: it must be very conservative because otherwise types looks okay but expressions don't
-    if (result.empty() || token == "::" || ends_with(result, "::") || token == ",")
+    if (result.empty() || std::strcmp(token, "::") == 0 || ends_with(result, "::")
+        || std::strcmp(token, ",") == 0)
         ; // never add whitespace
     else if (both_alpha(result, token) || result.back() == ',')
         // insert whitespace
         result += ' ';
-    result += token.c_str();
+    result += token;
 }
 
 void detail::erase_template_args(std::string& name)
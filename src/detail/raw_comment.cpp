@@ -7,6 +7,8 @@
 #include <cassert>
 #include <cstring>
 
+#include <standardese/detail/char_scan.hpp>
+
 using namespace standardese;
 
 namespace
@@ -24,20 +26,23 @@ namespace
         end_of_line,
     };
 
+    // ptr must be null-terminated or followed by at least three characters
     comment_style get_comment_style(const char*& ptr)
     {
-        if (std::strncmp(ptr, "///", 3) == 0 || std::strncmp(ptr, "//!", 3) == 0)
+        if (ptr[0] != '/')
+            return comment_style::none;
+        else if (ptr[1] == '/' && (ptr[2] == '/' || ptr[2] == '!'))
         {
             ptr += 3;
             return comment_style::cpp;
         }
-        else if (std::strncmp(ptr, "/**/", 4) != 0 // handle completely empty comment
-                 && (std::strncmp(ptr, "/**", 3) == 0 || std::strncmp(ptr, "/*!", 3) == 0))
+        else if (ptr[1] == '*' && (ptr[2] == '!' || (ptr[2] == '*' && ptr[3] != '/')))
         {
+            // "/**/" is a completely empty comment
             ptr += 3;
             return comment_style::c;
         }
-        else if (std::strncmp(ptr, "//<", 3) == 0)
+        else if (ptr[1] == '/' && ptr[2] == '<')
         {
             ptr += 3;
             return comment_style::end_of_line;
@@ -46,20 +51,47 @@ namespace
         return comment_style::none;
     }
 
-    detail::raw_comment parse_cpp_comment(const char*& ptr, unsigned& cur_line)
+    // returns the next '/' or '#', which can start a comment or a #line directive,
+    // and counts the newlines before it
+    const char* find_next_candidate(const char* ptr, const char* end, unsigned& cur_line)
+    {
+        for (; ptr + detail::char_block::size <= end; ptr += detail::char_block::size)
+        {
+            detail::char_block block(ptr);
+            auto               newlines = block.match('\n');
+            if (auto mask = block.match('/') | block.match('#'))
+            {
+                auto index = detail::count_trailing_zeros(mask);
+                cur_line += detail::count_bits(newlines & ((std::uint32_t(1u) << index) - 1u));
+                return ptr + index;
+            }
+            cur_line += detail::count_bits(newlines);
+        }
+
+        for (; ptr < end; ++ptr)
+            if (*ptr == '/' || *ptr == '#')
+                return ptr;
+            else if (*ptr == '\n')
+                ++cur_line;
+        return end;
+    }
+
+    detail::raw_comment parse_cpp_comment(const char*& ptr, const char* end, unsigned& cur_line)
     {
         // only skip one whitespace
         if (is_whitespace(*ptr))
             ++ptr;
 
-        std::string content;
-        for (; *ptr != '\n'; ++ptr)
-            content += *ptr;
-        assert(*ptr == '\n');
-        ++cur_line;
+        auto line_end = detail::find_char(ptr, end, '\n');
+        assert(line_end != end);
 
-        while (!content.empty() && is_whitespace(content.back()))
-            content.pop_back();
+        auto content_end = line_end;
+        while (content_end != ptr && is_whitespace(content_end[-1]))
+            --content_end;
+        std::string content(ptr, content_end);
+
+        ptr = line_end;
+        ++cur_line;
 
         // translate forward slash to backslash
         if (!content.empty() && content.back() == '/')
@@ -83,23 +115,17 @@ namespace
         }
     }
 
-    bool is_c_doc_comment_end(const char*& ptr)
+    // returns the beginning of the "*/" or "**/" in [begin, end) or nullptr
+    const char* find_c_doc_comment_end(const char* begin, const char* end)
     {
-        if (std::strncmp(ptr, "**/", 3) == 0)
-        {
-            ptr += 3;
-            return true;
-        }
-        else if (std::strncmp(ptr, "*/", 2) == 0)
-        {
-            ptr += 2;
-            return true;
-        }
-
-        return false;
+        for (auto ptr = detail::find_char(begin, end, '*'); ptr != end;
+             ptr      = detail::find_char(ptr + 1, end, '*'))
+            if (ptr[1] == '/')
+                return ptr != begin && ptr[-1] == '*' ? ptr - 1 : ptr;
+        return nullptr;
     }
 
-    detail::raw_comment parse_c_comment(const char*& ptr, unsigned& cur_line)
+    detail::raw_comment parse_c_comment(const char*& ptr, const char* end, unsigned& cur_line)
     {
         while (is_whitespace(*ptr))
             ++ptr;
@@ -109,42 +135,56 @@ namespace
         auto        needs_newline = false;
         while (true)
         {
-            if (*ptr == '\n')
-            {
-                while (!content.empty() && is_whitespace(content.back()))
-                    content.pop_back();
-                needs_newline = true;
-
-                ++ptr;
-                ++cur_line;
-                ++lines;
-
-                skip_c_doc_comment_continuation(ptr);
-                // handle empty line
-                if (*ptr == '\n')
-                    // need to append '\n', otherwise will be skipped
-                    content += '\n';
-            }
-            else if (*ptr == '/' && ptr[1] == '\n')
-            {
-                // translate to backslash
-                content += '\\';
-                ++ptr;
-            }
-            else if (is_c_doc_comment_end(ptr))
-                break;
-            else
+            // the comment is appended line by line
+            auto line_end    = detail::find_char(ptr, end, '\n');
+            auto comment_end = find_c_doc_comment_end(ptr, line_end);
+
+            auto segment_end = comment_end ? comment_end : line_end;
+            // translate a forward slash at the end of the line to backslash
+            auto backslash = !comment_end && line_end != end && segment_end != ptr
+                             && segment_end[-1] == '/';
+            if (backslash)
+                --segment_end;
+
+            if (segment_end != ptr)
             {
                 if (needs_newline)
                 {
                     content += '\n';
                     needs_newline = false;
                 }
-                content += *ptr++;
+                content.append(ptr, segment_end);
             }
+            if (backslash)
+                content += '\\';
+
+            if (comment_end)
+            {
+                // point to the final '/'
+                ptr = comment_end + (comment_end[1] == '*' ? 2 : 1);
+                break;
+            }
+            else if (line_end == end)
+            {
+                // unterminated comment
+                ptr = end - 1;
+                break;
+            }
+
+            while (!content.empty() && is_whitespace(content.back()))
+                content.pop_back();
+            needs_newline = true;
+
+            ptr = line_end + 1;
+            ++cur_line;
+            ++lines;
+
+            skip_c_doc_comment_continuation(ptr);
+            // handle empty line
+            if (*ptr == '\n')
+                // need to append '\n', otherwise will be skipped
+                content += '\n';
         }
-        assert(ptr[-1] == '/');
-        --ptr;
 
         while (!content.empty() && is_whitespace(content.back()))
             content.pop_back();
@@ -166,25 +206,31 @@ namespace
 
     std::string escape_html(const std::string& str)
     {
+        auto begin = str.data();
+        auto end   = begin + str.size();
+
         std::string result;
-        for (auto c : str)
-            if (c == '<')
-                result += "\\<";
-            else if (c == '>')
-                result += "\\>";
-            else
-                result += c;
+        result.reserve(str.size());
+        for (auto ptr = detail::find_first_of(begin, end, '<', '>'); ptr != end;
+             ptr      = detail::find_first_of(begin, end, '<', '>'))
+        {
+            result.append(begin, ptr);
+            result += '\\';
+            result += *ptr;
+            begin = ptr + 1;
+        }
+        result.append(begin, end);
         return result;
     }
 
     std::vector<detail::raw_comment> normalize(
-        const std::vector<std::pair<detail::raw_comment, comment_style>>& comments)
+        std::vector<std::pair<detail::raw_comment, comment_style>>& comments)
     {
         std::vector<detail::raw_comment> results;
 
         for (auto iter = comments.begin(); iter != comments.end(); ++iter)
         {
-            auto cur_content = iter->first.content;
+            auto cur_content = std::move(iter->first.content);
             auto cur_count   = iter->first.count_lines;
             auto cur_end     = iter->first.end_line;
             while (std::next(iter) != comments.end()
@@ -199,34 +245,30 @@ namespace
                 cur_content += iter->first.content;
             }
 
-            results.emplace_back(std::move(cur_content), cur_count, cur_end);
+            results.emplace_back(escape_html(cur_content), cur_count, cur_end);
         }
 
-        for (auto& comment : results)
-            comment.content = escape_html(comment.content);
-
         return results;
     }
 
-    bool parse_line_directive(const char*& ptr, unsigned& cur_line)
+    bool parse_line_directive(const char*& ptr, const char* end, unsigned& cur_line)
     {
-        auto line        = "#line";
-        auto line_length = std::strlen(line);
-        if (std::strncmp(ptr, line, line_length) != 0)
+        if (std::strncmp(ptr, "#line", 5u) != 0)
             return false;
 
-        ptr += line_length;
+        ptr += 5u;
         while (is_whitespace(*ptr))
             ++ptr;
 
-        std::string line_no;
-        while (!is_whitespace(*ptr))
-            line_no += *ptr++;
-        cur_line = static_cast<unsigned>(std::stoul(line_no));
-
-        while (*ptr != '\n')
-            // skip to end of line
+        auto line_no = ptr;
+        while (ptr != end && !is_whitespace(*ptr) && *ptr != '\n')
             ++ptr;
+        cur_line = static_cast<unsigned>(std::stoul(std::string(line_no, ptr)));
+
+        // skip to end of line
+        ptr = detail::find_char(ptr, end, '\n');
+        if (ptr == end)
+            --ptr;
 
         return true;
     }
@@ -242,21 +284,20 @@ std::vector<detail::raw_comment> detail::read_comments(const std::string& source
     assert(source.back() == '\n');
     std::vector<std::pair<detail::raw_comment, comment_style>> comments;
 
+    // only the characters that can start a comment or a #line directive are inspected,
+    // the lines in between are counted in bulk
     auto cur_line = 1u;
-    for (auto ptr = source.c_str(); *ptr; ++ptr)
+    auto end      = source.c_str() + source.size();
+    for (auto ptr = find_next_candidate(source.c_str(), end, cur_line); ptr < end;
+         ptr      = find_next_candidate(ptr + 1, end, cur_line))
     {
         auto style = get_comment_style(ptr);
-        if (style != comment_style::none)
-        {
-            if (style == comment_style::c)
-                comments.emplace_back(parse_c_comment(ptr, cur_line), style);
-            else
-                comments.emplace_back(parse_cpp_comment(ptr, cur_line), style);
-        }
-        else if (*ptr == '\n')
-            ++cur_line;
-
-        parse_line_directive(ptr, cur_line);
+        if (style == comment_style::c)
+            comments.emplace_back(parse_c_comment(ptr, end, cur_line), style);
+        else if (style != comment_style::none)
+            comments.emplace_back(parse_cpp_comment(ptr, end, cur_line), style);
+        else
+            parse_line_directive(ptr, end, cur_line);
     }
 
     return normalize(comments);
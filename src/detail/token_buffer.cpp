@@ -0,0 +1,117 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include <standardese/detail/token_buffer.hpp>
+
+#include <algorithm>
+#include <atomic>
+
+using namespace standardese;
+
+namespace
+{
+    std::atomic<std::size_t> tokenize_count(0u);
+
+    unsigned get_location_offset(CXSourceLocation loc)
+    {
+        unsigned offset;
+        clang_getSpellingLocation(loc, nullptr, nullptr, nullptr, &offset);
+        return offset;
+    }
+}
+
+void detail::tokenize(CXTranslationUnit tu, CXSourceRange range, CXToken** tokens,
+                      unsigned* no_tokens)
+{
+    tokenize_count.fetch_add(1u, std::memory_order_relaxed);
+    clang_tokenize(tu, range, tokens, no_tokens);
+}
+
+std::size_t detail::get_tokenize_count() STANDARDESE_NOEXCEPT
+{
+    return tokenize_count.load(std::memory_order_relaxed);
+}
+
+detail::token_buffer::token_buffer(CXTranslationUnit tu, CXSourceRange range) : file_(nullptr)
+{
+    clang_getSpellingLocation(clang_getRangeStart(range), &file_, nullptr, nullptr, nullptr);
+
+    CXToken* cx_tokens;
+    unsigned no_tokens;
+    tokenize(tu, range, &cx_tokens, &no_tokens);
+
+    // the spellings are copied into one buffer first,
+    // the tokens can only refer to them once it doesn't grow anymore
+    std::vector<std::size_t> spelling_offsets;
+    spelling_offsets.reserve(no_tokens);
+    end_offsets_.reserve(no_tokens);
+    for (auto cur = cx_tokens; cur != cx_tokens + no_tokens; ++cur)
+    {
+        string spelling(clang_getTokenSpelling(tu, *cur));
+        spelling_offsets.push_back(spellings_.size());
+        spellings_.insert(spellings_.end(), spelling.begin(), spelling.end() + 1);
+
+        auto extent = clang_getTokenExtent(tu, *cur);
+        end_offsets_.push_back(get_location_offset(clang_getRangeEnd(extent)));
+    }
+
+    tokens_.reserve(no_tokens);
+    for (auto i = 0u; i != no_tokens; ++i)
+    {
+        auto spelling = spellings_.data() + spelling_offsets[i];
+        auto length   = (i + 1u == no_tokens ? spellings_.size() : spelling_offsets[i + 1u])
+                      - spelling_offsets[i] - 1u;
+        auto offset = get_location_offset(clang_getTokenLocation(tu, cx_tokens[i]));
+        tokens_.emplace_back(token_spelling(spelling, length), clang_getTokenKind(cx_tokens[i]),
+                             offset);
+    }
+
+    if (cx_tokens)
+        clang_disposeTokens(tu, cx_tokens, no_tokens);
+}
+
+detail::token_buffer::token_buffer(CXTranslationUnit tu, CXFile file, unsigned size)
+: token_buffer(tu, clang_getRange(clang_getLocationForOffset(tu, file, 0u),
+                                  clang_getLocationForOffset(tu, file, size)))
+{
+}
+
+const detail::token* detail::token_buffer::find(unsigned offset) const STANDARDESE_NOEXCEPT
+{
+    auto iter = std::lower_bound(begin(), end(), offset, [](const token& t, unsigned off) {
+        return t.get_offset() < off;
+    });
+    if (iter != begin() && get_end_offset(iter - 1) > offset)
+        // lexing would start in the middle of the previous token
+        return nullptr;
+    return iter;
+}
+
+bool detail::token_buffer::get_tokens(CXSourceRange range, const token*& begin,
+                                      const token*& end) const STANDARDESE_NOEXCEPT
+{
+    if (empty())
+        return false;
+
+    CXFile   file;
+    unsigned begin_offset, end_offset;
+    clang_getSpellingLocation(clang_getRangeStart(range), &file, nullptr, nullptr, &begin_offset);
+    clang_getSpellingLocation(clang_getRangeEnd(range), nullptr, nullptr, nullptr, &end_offset);
+    if (file != file_)
+        return false;
+
+    auto first = find(begin_offset);
+    if (!first || first == this->end())
+        return false;
+
+    // clang_tokenize() lexes the first token
+    // and continues as long as the previous token ends before the end of the range
+    auto last = first + 1;
+    while (last != this->end() && get_end_offset(last - 1) < end_offset)
+        ++last;
+
+    begin = first;
+    end   = last;
+    return true;
+}
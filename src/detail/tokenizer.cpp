@@ -9,23 +9,6 @@
 
 using namespace standardese;
 
-namespace
-{
-    unsigned get_token_offset(CXTranslationUnit tu, CXToken token)
-    {
-        unsigned offset;
-        auto     location = clang_getTokenLocation(tu, token);
-        clang_getSpellingLocation(location, nullptr, nullptr, nullptr, &offset);
-        return offset;
-    }
-}
-
-detail::token::token(CXTranslationUnit tu, CXToken token)
-: detail::token(clang_getTokenSpelling(tu, token), clang_getTokenKind(token),
-                get_token_offset(tu, token))
-{
-}
-
 namespace
 {
     bool cursor_is_function(CXCursorKind kind)
@@ -43,13 +26,18 @@ namespace
         return clang_getLocationForOffset(tu, file, offset + inc);
     }
 
-    string get_token_after(CXTranslationUnit tu, CXFile file, CXSourceLocation loc)
+    string get_token_after(CXTranslationUnit tu, CXFile file, const detail::token_buffer* buffer,
+                           CXSourceLocation loc)
     {
-        auto loc_after = get_next_location(tu, file, loc);
+        auto range = clang_getRange(loc, get_next_location(tu, file, loc));
+
+        const detail::token *begin, *end;
+        if (buffer && buffer->get_tokens(range, begin, end))
+            return string(begin->get_value().c_str(), begin->get_value().length());
 
         CXToken* token;
         unsigned no;
-        clang_tokenize(tu, clang_getRange(loc, loc_after), &token, &no);
+        detail::tokenize(tu, range, &token, &no);
 
         assert(no >= 1);
         string spelling(clang_getTokenSpelling(tu, token[0]));
@@ -58,8 +46,8 @@ namespace
         return spelling;
     }
 
-    CXSourceRange get_extent(CXTranslationUnit tu, CXFile file, cpp_cursor cur,
-                             unsigned& end_offset, const char*& end_token)
+    CXSourceRange get_extent(CXTranslationUnit tu, CXFile file, const detail::token_buffer* buffer,
+                             cpp_cursor cur, unsigned& end_offset, const char*& end_token)
     {
         end_token = ";";
 
@@ -87,13 +75,13 @@ namespace
                 return CXChildVisit_Continue;
             });
 
-            if (!range_shrunk && get_token_after(tu, file, end) != ";")
+            if (!range_shrunk && get_token_after(tu, file, buffer, end) != ";")
             {
                 // we do not have a body, but it is not a declaration either
                 do
                 {
                     end = get_next_location(tu, file, end);
-                } while (get_token_after(tu, file, end) != ";");
+                } while (get_token_after(tu, file, buffer, end) != ";");
             }
             else if (clang_getCursorKind(cur) == CXCursor_CXXMethod)
                 // necessary for some reason
@@ -105,7 +93,7 @@ namespace
                  || clang_getCursorKind(cur) == CXCursor_ParmDecl)
         {
             if (clang_getCursorKind(cur) == CXCursor_TemplateTypeParameter
-                && get_token_after(tu, file, end) == "(")
+                && get_token_after(tu, file, buffer, end) == "(")
             {
                 // if you have decltype as default argument for a type template parameter
                 // libclang doesn't include the parameters
@@ -114,7 +102,7 @@ namespace
                 for (auto paren_count = 1; paren_count != 0;
                      next             = get_next_location(tu, file, next))
                 {
-                    auto spelling = get_token_after(tu, file, next);
+                    auto spelling = get_token_after(tu, file, buffer, next);
                     if (spelling == "(")
                         ++paren_count;
                     else if (spelling == ")")
@@ -129,13 +117,13 @@ namespace
                 range_shrunk = true;
         }
         else if (clang_getCursorKind(cur) == CXCursor_TypeAliasDecl
-                 && get_token_after(tu, file, end) != ";")
+                 && get_token_after(tu, file, buffer, end) != ";")
         {
             // type alias tokens don't include everything
             do
             {
                 end = get_next_location(tu, file, end);
-            } while (get_token_after(tu, file, end) != ";");
+            } while (get_token_after(tu, file, buffer, end) != ";");
             end = get_next_location(tu, file, end);
         }
 
@@ -146,18 +134,19 @@ namespace
         return clang_getRange(begin, end);
     }
 
-    CXSourceRange get_extent(CXTranslationUnit tu, CXFile file, cpp_cursor cur)
+    CXSourceRange get_extent(CXTranslationUnit tu, CXFile file, const detail::token_buffer* buffer,
+                             cpp_cursor cur)
     {
         unsigned    unused;
         const char* unused2;
-        return get_extent(tu, file, cur, unused, unused2);
+        return get_extent(tu, file, buffer, cur, unused, unused2);
     }
 }
 
 CXFile detail::get_range(const translation_unit& tu, cpp_cursor cur, unsigned& begin_offset,
                          unsigned& end_offset)
 {
-    auto source = get_extent(tu.get_cxunit(), tu.get_cxfile(), cur);
+    auto source = get_extent(tu.get_cxunit(), tu.get_cxfile(), &tu.get_file().get_tokens(), cur);
     return get_range(source, begin_offset, end_offset);
 }
 
@@ -176,68 +165,59 @@ CXFile detail::get_range(CXSourceRange extent, unsigned& begin_offset, unsigned&
     return file;
 }
 
-detail::tokenizer::tokenizer(CXTranslationUnit tu, CXFile file, cpp_cursor cur)
-: tu_(tu), file_(file)
-{
-    clang_tokenize(get_cxunit(), get_extent(get_cxunit(), get_cxfile(), cur, end_offset_, end_),
-                   &tokens_, &no_tokens_);
-    assert(tokens_);
-}
-
-detail::tokenizer::~tokenizer() STANDARDESE_NOEXCEPT
-{
-    if (tokens_)
-        clang_disposeTokens(get_cxunit(), tokens_, no_tokens_);
-}
-
 namespace
 {
-    CXToken* get_actual_end(CXTranslationUnit tu, CXToken* tokens, unsigned no_tokens,
-                            unsigned end_offset)
+    detail::token_iterator get_actual_end(detail::token_iterator begin,
+                                          detail::token_iterator end, unsigned end_offset)
     {
         // need to find the last token that is actually part of the cursor
         // libclang is always good with the extent of cursors
-        auto end = tokens + no_tokens;
-        while (get_token_offset(tu, end[-1]) > end_offset)
+        while (end[-1].get_offset() > end_offset)
         {
-            assert(end > tokens);
+            assert(end > begin);
             --end;
         }
 
         return end;
     }
-}
 
-detail::token_iterator detail::tokenizer::end() const STANDARDESE_NOEXCEPT
-{
-    auto end = get_actual_end(get_cxunit(), tokens_, no_tokens_, end_offset_);
-    return token_iterator(get_cxunit(), end);
+    CXFile get_tu_file(const translation_unit& tu)
+    {
+        auto& buffer = tu.get_file().get_tokens();
+        // the buffer already knows the file, which saves the lookup by name
+        return buffer.empty() ? tu.get_cxfile() : buffer.get_cxfile();
+    }
 }
 
-namespace
+detail::tokenizer::tokenizer(CXTranslationUnit tu, CXFile file, cpp_cursor cur,
+                             const token_buffer* buffer)
+: tu_(tu), file_(file), buffer_(buffer)
 {
-    CXSourceRange get_following_range(CXTranslationUnit tu, CXFile file, unsigned end_offset)
+    auto extent = get_extent(get_cxunit(), get_cxfile(), buffer_, cur, end_offset_, end_token_);
+    if (!buffer_ || !buffer_->get_tokens(extent, begin_, end_))
     {
-        auto begin = clang_getLocationForOffset(tu, file, end_offset + 1);
-        auto end   = clang_getLocationForOffset(tu, file, end_offset + 2);
-        return clang_getRange(begin, end);
+        // the range doesn't start at a token of the buffer
+        owned_ = token_buffer(get_cxunit(), extent);
+        begin_ = owned_.begin();
+        end_   = owned_.end();
     }
+    assert(begin_ != end_);
+
+    end_ = get_actual_end(begin_, end_, end_offset_);
+}
+
+detail::tokenizer::tokenizer(const translation_unit& tu, cpp_cursor cur)
+: tokenizer(tu.get_cxunit(), get_tu_file(tu), cur, &tu.get_file().get_tokens())
+{
 }
 
 bool detail::tokenizer::need_unmunch() const STANDARDESE_NOEXCEPT
 {
-    CXToken* next_tokens;
-    unsigned no;
-    clang_tokenize(get_cxunit(), get_following_range(get_cxunit(), get_cxfile(), end_offset_),
-                   &next_tokens, &no);
-
-    assert(no >= 1);
-    auto next_spelling = string(clang_getTokenSpelling(get_cxunit(), *next_tokens));
-    auto valid_token   = next_spelling == ">"
-                       || next_spelling == ","; // must be comma or end of template argument list
-
-    clang_disposeTokens(get_cxunit(), next_tokens, no);
-    return !valid_token;
+    auto next_spelling =
+        get_token_after(get_cxunit(), get_cxfile(), buffer_,
+                        clang_getLocationForOffset(get_cxunit(), get_cxfile(), end_offset_ + 1));
+    // must be comma or end of template argument list
+    return next_spelling != ">" && next_spelling != ",";
 }
 
 void detail::skip_offset(detail::token_stream& stream, unsigned offset)
@@ -48,8 +48,10 @@ const std::string& doc_entity::get_module() const STANDARDESE_NOEXCEPT
 
 cpp_name doc_entity::get_unique_name() const
 {
-    return detail::get_unique_name(has_parent() ? &get_parent() : nullptr, do_get_unique_name(),
-                                   comment_);
+    return unique_name_.get([&] {
+        return detail::get_unique_name(has_parent() ? &get_parent() : nullptr,
+                                       do_get_unique_name(), comment_);
+    });
 }
 
 doc_entity::doc_entity(doc_entity::type t, const doc_entity* parent,
@@ -1389,13 +1391,22 @@ namespace
 doc_ptr<doc_file> doc_file::parse(const parser& p, const index& i, std::string output_name,
                                   const cpp_file& f)
 {
+    // the entities are allocated in the arena of the file, in the order they are parsed
+    auto                                   arena = std::make_shared<detail::entity_arena>();
+    detail::entity_arena_scope<doc_entity> arena_scope(arena.get());
+
     auto file_ptr =
         detail::make_doc_ptr<doc_container_cpp_entity>(nullptr, f, p.get_comment_registry()
                                                                        .lookup_comment(f, nullptr));
     if (file_ptr->has_comment() && file_ptr->get_comment().has_unique_name_override())
         output_name = file_ptr->get_comment().get_unique_name_override();
 
-    auto res = detail::make_doc_ptr<doc_file>(output_name, std::move(file_ptr));
+    auto res = [&] {
+        // the file owns the arena, so it can't be allocated in it
+        detail::entity_arena_scope<doc_entity> heap(nullptr);
+        return detail::make_doc_ptr<doc_file>(output_name, std::move(file_ptr));
+    }();
+    res->arena_ = std::move(arena);
     res->file_->set_parent(res.get());
 
     for (auto& child : f)
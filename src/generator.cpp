@@ -23,6 +23,26 @@ standardese::documentation standardese::generate_doc_file(const parser& p, const
     return {std::move(file), std::move(doc)};
 }
 
+namespace
+{
+    void detach_entity(const doc_entity& e)
+    {
+        e.get_name();
+        e.get_unique_name();
+        for (auto i = 0; i != 4; ++i)
+            e.get_index_name(i >= 2, i % 2 == 1);
+
+        for (auto& child : e)
+            detach_entity(child);
+    }
+}
+
+void standardese::detach_doc_file(const documentation& doc)
+{
+    if (doc.file)
+        detach_entity(*doc.file);
+}
+
 namespace
 {
     using standardese::index;
@@ -6,6 +6,8 @@
 
 #include <algorithm>
 #include <cctype>
+#include <cstring>
+#include <stdexcept>
 #include <spdlog/fmt/fmt.h>
 
 #include <standardese/comment.hpp>
@@ -72,19 +74,41 @@ std::string detail::get_short_id(const std::string& id)
 void index::register_entity(const parser& p, const doc_entity& entity,
                             std::string output_file) const
 {
-    auto id       = detail::get_id(entity.get_unique_name().c_str());
-    auto short_id = detail::get_short_id(id);
+    register_impl(p, entity);
+    linker_.register_entity(entity, std::move(output_file));
+}
 
-    std::lock_guard<std::mutex> lock(mutex_);
+void index::register_entity(const parser& p, const doc_entity& entity, std::string output_file,
+                            std::string anchor_id) const
+{
+    register_impl(p, entity);
+    linker_.register_entity(entity, std::move(output_file), std::move(anchor_id));
+}
+
+void index::register_impl(const parser& p, const doc_entity& entity) const
+{
+    auto& strings  = p.get_string_table();
+    auto  id       = detail::get_id(entity.get_unique_name().c_str());
+    auto  short_id = detail::get_short_id(id);
+
+    auto id_name       = strings.intern(id.c_str(), id.size());
+    auto short_id_name = short_id != id ? strings.intern(short_id.c_str(), short_id.size()) :
+                                          id_name;
+
+    auto lock = lock_profiled(mutex_, p.get_profiler(), "index");
+    // checked under the lock, freeze() holds it as well
+    if (is_frozen())
+        throw std::logic_error("index: registration after freeze()");
 
     // insert short id if it doesn't exist
     // otherwise erase
-    if (short_id != id)
+    if (short_id_name != id_name)
     {
-        auto iter = entities_.find(short_id);
+        auto iter = entities_.find(short_id_name);
         if (iter == entities_.end())
         {
-            auto res = entities_.emplace(std::move(short_id), std::make_pair(true, &entity)).second;
+            auto res = entities_.emplace(std::move(short_id_name), std::make_pair(true, &entity))
+                           .second;
             assert(res);
             (void)res;
         }
@@ -94,38 +118,65 @@ void index::register_entity(const parser& p, const doc_entity& entity,
     }
 
     // insert long id
-    auto pair = entities_.emplace(std::move(id), std::make_pair(false, &entity));
+    auto pair = entities_.emplace(std::move(id_name), std::make_pair(false, &entity));
     if (!pair.second && entity.get_cpp_entity_type() != cpp_entity::namespace_t)
         p.get_logger()->warn("duplicate index registration of an entity named '{}'",
                              entity.get_unique_name().c_str());
-    else if (pair.first->second.second->get_cpp_entity_type() == cpp_entity::file_t)
-    {
-        using value_type = decltype(files_)::value_type;
-        auto pos         = std::lower_bound(files_.begin(), files_.end(), pair.first,
-                                    [](value_type a, value_type b) { return a->first < b->first; });
-        files_.insert(pos, pair.first);
-    }
 
+    // sorted by freeze()
     if (entity.in_module())
+        modules_.push_back(entity.get_module());
+}
+
+void index::freeze()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (is_frozen())
+        return;
+
+    frozen_entities_.reserve(entities_.size());
+    for (auto& pair : entities_)
+        frozen_entities_.push_back({pair.first, pair.second.second, pair.second.first});
+    entities_.clear();
+
+    std::sort(frozen_entities_.begin(), frozen_entities_.end(),
+              [](const frozen_entry& a, const frozen_entry& b) { return a.id < b.id; });
+    for (auto& entry : frozen_entities_)
+        if (!entry.short_id && entry.entity->get_cpp_entity_type() == cpp_entity::file_t)
+            files_.push_back(entry.entity);
+
+    std::sort(modules_.begin(), modules_.end());
+
+    frozen_.store(true, std::memory_order_release);
+}
+
+const doc_entity* index::lookup_id(const std::string& id) const
+{
+    if (is_frozen())
     {
-        auto pos = std::lower_bound(modules_.begin(), modules_.end(), entity.get_module());
-        modules_.insert(pos, entity.get_module());
+        auto iter = std::lower_bound(frozen_entities_.begin(), frozen_entities_.end(), id,
+                                     [](const frozen_entry& entry, const std::string& value) {
+                                         return std::strcmp(entry.id.c_str(), value.c_str()) < 0;
+                                     });
+        return iter == frozen_entities_.end() || iter->id != id.c_str() ? nullptr : iter->entity;
     }
 
-    linker_.register_entity(entity, std::move(output_file));
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto                        iter = entities_.find(cpp_name(id));
+    return iter == entities_.end() ? nullptr : iter->second.second;
 }
 
 const doc_entity* index::try_lookup(const std::string& unique_name) const
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto                        iter = entities_.find(detail::get_id(unique_name));
-    return iter == entities_.end() ? nullptr : iter->second.second;
+    return lookup_id(detail::get_id(unique_name));
 }
 
 const doc_entity& index::lookup(const std::string& unique_name) const
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return *entities_.at(detail::get_id(unique_name)).second;
+    auto entity = try_lookup(unique_name);
+    if (!entity)
+        throw std::out_of_range(fmt::format("unable to find entity named '{}'", unique_name));
+    return *entity;
 }
 
 const doc_entity* index::try_name_lookup(const doc_entity&  context,
@@ -163,13 +214,13 @@ const doc_entity& index::name_lookup(const doc_entity&  context,
 
 void index::namespace_member_impl(ns_member_cb cb, void* data)
 {
-    for (auto& pair : entities_)
+    freeze();
+    for (auto& entry : frozen_entities_)
     {
-        auto& value = pair.second;
-        if (value.first)
+        if (entry.short_id)
             continue; // ignore short names
 
-        auto& entity = *value.second;
+        auto& entity = *entry.entity;
         if (entity.get_cpp_entity_type() == cpp_entity::namespace_t
             || entity.get_cpp_entity_type() == cpp_entity::file_t)
             continue;
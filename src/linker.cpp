@@ -106,7 +106,21 @@ void linker::register_entity(const doc_entity& e, std::string output_file) const
     auto loc = location(get_documented_entity(e), "doc_" + std::move(output_file));
 
     std::unique_lock<std::mutex> lock(mutex_);
-    auto                         res = locations_.emplace(&e, std::move(loc));
+    check_not_frozen();
+    auto res = locations_.emplace(&e, std::move(loc));
+    if (!res.second)
+        throw std::logic_error(fmt::format("linker: duplicate registration of entity '{}'",
+                                           e.get_unique_name().c_str()));
+}
+
+void linker::register_entity(const doc_entity& e, std::string output_file,
+                             std::string anchor_id) const
+{
+    auto loc = location("doc_" + std::move(output_file), std::move(anchor_id), true);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    check_not_frozen();
+    auto res = locations_.emplace(&e, std::move(loc));
     if (!res.second)
         throw std::logic_error(fmt::format("linker: duplicate registration of entity '{}'",
                                            e.get_unique_name().c_str()));
@@ -117,6 +131,7 @@ std::string linker::register_anchor(const std::string& unique_name, std::string
     location loc(unique_name.c_str(), std::move(output_file));
     {
         std::unique_lock<std::mutex> lock(mutex_);
+        check_not_frozen();
         auto                         res = anchors_.emplace(unique_name, loc);
         if (!res.second)
             res.first->second = loc;
@@ -127,6 +142,7 @@ std::string linker::register_anchor(const std::string& unique_name, std::string
 void linker::change_output_file(const doc_entity& e, std::string output_file) const
 {
     std::unique_lock<std::mutex> lock(mutex_);
+    check_not_frozen();
     locations_.at(&e).set_output_file(std::move(output_file));
 }
 
@@ -140,8 +156,8 @@ std::string linker::get_url(const index& idx, const external_linker& external,
         return get_url(*entity, extension);
 
     {
-        std::unique_lock<std::mutex> lock(mutex_);
-        auto                         iter = anchors_.find(unique_name);
+        auto lock = lock_reader();
+        auto iter = anchors_.find(unique_name);
         if (iter != anchors_.end())
             return iter->second.format(extension);
     }
@@ -151,16 +167,37 @@ std::string linker::get_url(const index& idx, const external_linker& external,
 
 std::string linker::get_url(const doc_entity& e, const char* extension) const
 {
-    std::unique_lock<std::mutex> lock(mutex_);
+    auto lock = lock_reader();
     return locations_.at(&e).format(extension);
 }
 
 std::string linker::get_anchor_id(const doc_entity& e) const
 {
-    std::unique_lock<std::mutex> lock(mutex_);
+    auto lock = lock_reader();
     return locations_.at(&e).get_id();
 }
 
+void linker::freeze()
+{
+    // a modification holding the lock has already passed its check, wait for it
+    std::lock_guard<std::mutex> lock(mutex_);
+    frozen_.store(true, std::memory_order_release);
+}
+
+std::unique_lock<std::mutex> linker::lock_reader() const
+{
+    // the tables aren't modified after freezing
+    if (is_frozen())
+        return std::unique_lock<std::mutex>();
+    return std::unique_lock<std::mutex>(mutex_);
+}
+
+void linker::check_not_frozen() const
+{
+    if (is_frozen())
+        throw std::logic_error("linker: modification after freeze()");
+}
+
 md_ptr<md_anchor> linker::get_anchor(const doc_entity& e, const md_entity& parent) const
 {
     return md_anchor::make(parent, get_anchor_id(e).c_str());
@@ -177,6 +214,11 @@ linker::location::location(const char* unique_name, std::string output_file)
     set_output_file(std::move(output_file));
 }
 
+linker::location::location(std::string output_file, std::string id, bool) : id_(std::move(id))
+{
+    set_output_file(std::move(output_file));
+}
+
 void linker::location::set_output_file(std::string output_file)
 {
     file_name_      = std::move(output_file);
@@ -100,9 +100,10 @@ std::string standardese::detail::normalize_url(const char* str)
     return result;
 }
 
-void standardese::normalize_urls(const index& idx, md_container& document,
+bool standardese::normalize_urls(const index& idx, md_container& document,
                                  const doc_entity* default_context)
 {
+    auto complete = true;
     for_each_entity_reference(document, [&](const doc_entity* context, md_link& link) {
         auto str = get_entity_name(link);
         if (str.empty())
@@ -112,6 +113,12 @@ void standardese::normalize_urls(const index& idx, md_container& document,
             context = default_context;
 
         auto entity = context ? idx.try_name_lookup(*context, str) : idx.try_lookup(str);
+        if (!entity || str.front() == '?' || str.front() == '*')
+            complete = false;
+        else if (detail::get_id(entity->get_unique_name().c_str()) != detail::get_id(str))
+            // found through a short id, which is erased when another entity has the same one
+            complete = false;
+
         if (entity)
             link.set_destination(
                 ("standardese://" + detail::normalize_url(entity->get_unique_name().c_str()) + '/')
@@ -119,6 +126,7 @@ void standardese::normalize_urls(const index& idx, md_container& document,
         else
             link.set_destination(("standardese://" + str + '/').c_str());
     });
+    return complete;
 }
 
 raw_document::raw_document(path fname, std::string text)
@@ -132,30 +140,39 @@ raw_document::raw_document(path fname, std::string text)
     }
 }
 
-void output::render(const std::shared_ptr<spdlog::logger>& logger, const md_document& doc,
-                    const char* output_extension)
+raw_document output::get_raw(const md_document& doc)
 {
     // normalize URLs
     auto document = md_ptr<md_document>(static_cast<md_document*>(doc.clone().release()));
-    normalize_urls(*index_, *document);
+    auto complete = normalize_urls(*index_, *document);
 
     // get string
     string_output str;
     format_->render(str, *document);
 
-    // get raw_document
-    raw_document raw(document->get_output_name(), str.get_string());
-    render_raw(logger, raw, output_extension);
+    raw_document result(document->get_output_name(), str.get_string());
+    result.complete = complete;
+    return result;
 }
 
-void output::render_template(const std::shared_ptr<spdlog::logger>& logger,
-                             const template_file& templ, const documentation& doc,
-                             const char* output_extension)
+raw_document output::get_raw(const template_file& templ, const documentation& doc)
 {
     auto document      = process_template(*parser_, *index_, templ, format_, &doc);
     document.file_name = doc.document->get_output_name();
+    return document;
+}
 
-    render_raw(logger, document, output_extension);
+void output::render(const std::shared_ptr<spdlog::logger>& logger, const md_document& doc,
+                    const char* output_extension)
+{
+    render_raw(logger, get_raw(doc), output_extension);
+}
+
+void output::render_template(const std::shared_ptr<spdlog::logger>& logger,
+                             const template_file& templ, const documentation& doc,
+                             const char* output_extension)
+{
+    render_raw(logger, get_raw(templ, doc), output_extension);
 }
 
 namespace
@@ -4,6 +4,14 @@
 
 #include <standardese/parser.hpp>
 
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <iterator>
+
+#include <boost/filesystem.hpp>
+
+#include <standardese/detail/raw_comment.hpp>
 #include <standardese/detail/tokenizer.hpp>
 #include <standardese/cpp_preprocessor.hpp>
 #include <standardese/error.hpp>
@@ -18,28 +26,47 @@ namespace
         return CXDiagnostic_DisplayOption;
     }
 
-    CXTranslationUnit get_cxunit(const std::shared_ptr<spdlog::logger>& log, CXIndex index,
-                                 const compile_config& c, const char* full_path,
-                                 const std::string& source)
+    std::vector<const char*> get_args(const compile_config& c)
     {
         auto args = c.get_flags();
         // allow detection of friend definitions
         args.push_back("-D__standardese_friend=static");
+        return args;
+    }
 
+    CXUnsavedFile make_unsaved_file(const char* name, const std::string& source)
+    {
         CXUnsavedFile file;
-        file.Filename = full_path;
+        file.Filename = name;
         file.Contents = source.c_str();
         file.Length   = source.length();
+        return file;
+    }
 
-        CXTranslationUnit tu;
-        auto              error = clang_parseTranslationUnit2(index, full_path, args.data(),
-                                                 static_cast<int>(args.size()), &file, 1,
-                                                 CXTranslationUnit_Incomplete
+    // files contains the source of the main file and possibly other files
+    CXTranslationUnit get_cxunit(const std::shared_ptr<spdlog::logger>& log, CXIndex index,
+                                 const compile_config& c, const char* full_path,
+                                 std::vector<CXUnsavedFile>& files,
+                                 const detail::preamble*     preamble)
+    {
+        auto args = get_args(c);
+        if (preamble)
+        {
+            args.push_back("-include-pch");
+            args.push_back(preamble->pch_file.c_str());
+        }
+
+        // the preprocessing record is required for the macro definitions
+        unsigned flags =
+            CXTranslationUnit_Incomplete | CXTranslationUnit_DetailedPreprocessingRecord;
 #if CINDEX_VERSION_MINOR >= 34
-                                                     | CXTranslationUnit_KeepGoing
+        flags |= CXTranslationUnit_KeepGoing;
 #endif
-                                                 ,
-                                                 &tu);
+
+        CXTranslationUnit tu;
+        auto              error = clang_parseTranslationUnit2(index, full_path, args.data(),
+                                                 static_cast<int>(args.size()), files.data(),
+                                                 static_cast<unsigned>(files.size()), flags, &tu);
         if (error != CXError_Success)
             throw libclang_error(error, "CXTranslationUnit (" + std::string(full_path) + ")");
 
@@ -61,44 +88,113 @@ namespace
         return tu;
     }
 
-    std::string replace_friend_definitions(const std::string& preprocessed)
+    std::string get_preamble_key(const compile_config& c)
     {
-        std::string output;
-
-        auto last_match = preprocessed.c_str();
-        while (const char* match = std::strstr(last_match, "friend"))
+        std::string result;
+        for (auto& flag : c)
+        {
+            result += flag.c_str();
+            result += '\n';
+        }
+        for (auto& header : c.get_preamble_headers())
         {
-            output.append(last_match, match);
+            result += header;
+            result += '\n';
+        }
+        return result;
+    }
 
-            auto ptr = match;
-            for (auto paren_count = 0; *ptr && *ptr != ';'; ++ptr)
-            {
-                if (*ptr == '(')
-                    ++paren_count;
-                else if (*ptr == ')')
-                    --paren_count;
-                else if (paren_count == 0 && *ptr == '{')
-                    // friend function definition
-                    break;
-            }
+    unsigned get_milliseconds(std::chrono::steady_clock::time_point begin)
+    {
+        auto duration = std::chrono::steady_clock::now() - begin;
+        return unsigned(std::chrono::duration_cast<std::chrono::milliseconds>(duration).count());
+    }
+}
 
-            last_match = ptr;
-            if (!*ptr || *ptr == ';')
-                // other friend, keep
-                output.append(match, ptr);
-            else
-            {
-                // friend function definition, replace keyword
-                output += "__standardese_friend";
-                match += std::strlen("friend");
-                output.append(match, ptr);
-            }
-        }
-        output.append(last_match, &preprocessed.back() + 1);
-        return output;
+detail::preamble::~preamble() STANDARDESE_NOEXCEPT
+{
+    if (!pch_file.empty())
+    {
+        boost::system::error_code ec;
+        boost::filesystem::remove(pch_file, ec);
     }
 }
 
+std::shared_ptr<const detail::preamble> parser::get_preamble(const compile_config& c) const
+{
+    namespace fs = boost::filesystem;
+
+    if (c.get_preamble_headers().empty())
+        return nullptr;
+
+    auto key = get_preamble_key(c);
+
+    std::lock_guard<std::mutex> lock(preamble_mutex_);
+    if (preamble_ && preamble_->key == key)
+        return preamble_->pch_file.empty() ? nullptr : preamble_;
+
+    // the previous preamble stays alive until its translation units are released,
+    // a failed build is stored as well, so it isn't retried for every file
+    auto result = std::make_shared<detail::preamble>(std::move(key));
+    preamble_   = result;
+
+    std::string source;
+    for (auto& header : c.get_preamble_headers())
+        source += "#include " + header + '\n';
+
+    auto path = (fs::temp_directory_path() / fs::unique_path("standardese-%%%%-%%%%-%%%%.hpp"))
+                    .generic_string();
+
+    // parse as header
+    auto args = get_args(c);
+    for (auto iter = args.begin(); iter != args.end(); ++iter)
+        if (std::strcmp(*iter, "-x") == 0 && std::next(iter) != args.end())
+            *++iter = "c++-header";
+
+    CXUnsavedFile file;
+    file.Filename = path.c_str();
+    file.Contents = source.c_str();
+    file.Length   = source.length();
+
+    auto              begin = std::chrono::steady_clock::now();
+    CXTranslationUnit tu;
+    auto error = clang_parseTranslationUnit2(index_.get(), path.c_str(), args.data(),
+                                             static_cast<int>(args.size()), &file, 1,
+                                             CXTranslationUnit_Incomplete
+                                                 | CXTranslationUnit_ForSerialization,
+                                             &tu);
+    if (error != CXError_Success)
+    {
+        logger_->warn("unable to parse the preamble, parsing without it");
+        return nullptr;
+    }
+    detail::tu_wrapper wrapper(tu);
+
+    clang_getInclusions(tu,
+                        [](CXFile included, CXSourceLocation*, unsigned depth,
+                           CXClientData data) {
+                            if (depth != 0u)
+                                static_cast<std::vector<std::string>*>(data)->push_back(
+                                    string(clang_getFileName(included)).c_str());
+                        },
+                        &result->dependencies);
+
+    auto pch = fs::path(path).replace_extension(".pch").generic_string();
+    if (clang_saveTranslationUnit(tu, pch.c_str(), clang_defaultSaveOptions(tu))
+        != CXSaveError_None)
+    {
+        logger_->warn("unable to save the precompiled preamble, parsing without it");
+        return nullptr;
+    }
+
+    result->pch_file   = std::move(pch);
+    result->build_time = get_milliseconds(begin);
+    logger_->info("Precompiled preamble of {} header(s) in {}ms", c.get_preamble_headers().size(),
+                  result->build_time);
+
+    return result;
+}
+
 translation_unit parser::parse(const char* full_path, const compile_config& c,
                                const char* file_name) const
 {
@@ -108,19 +204,158 @@ translation_unit parser::parse(const char* full_path, const compile_config& c,
     auto              file_ptr = file.get();
     files_.add_file(std::move(file));
 
-    auto preprocessed = preprocessor_.preprocess(*this, c, full_path, *file_ptr);
-    auto tu =
-        get_cxunit(logger_, index_.get(), c, full_path, replace_friend_definitions(preprocessed));
-    parse_comments(*this, file_name, preprocessed);
+    // the entities are allocated in the arena of the file, in the order they are parsed
+    file_ptr->arena_ = std::make_shared<detail::entity_arena>();
+    detail::entity_arena_scope<cpp_entity> arena(file_ptr->arena_.get());
+
+    auto        preamble = get_preamble(c);
+    std::string source;
+    {
+        profile_timer timer(profiler_, file_name, profile_phase::preprocess);
+        // the friend definitions are already rewritten
+        source = preprocessor_.preprocess(*this, c, full_path, *file_ptr);
+        timer.set_bytes(source.size());
+    }
+    std::vector<CXUnsavedFile> files{make_unsaved_file(full_path, source)};
 
-    file_ptr->wrapper_ = detail::tu_wrapper(tu);
+    auto begin = std::chrono::steady_clock::now();
+    auto tu    = [&] {
+        profile_timer timer(profiler_, file_name, profile_phase::parse);
+        return get_cxunit(logger_, index_.get(), c, full_path, files, preamble.get());
+    }();
+    if (preamble)
+    {
+        // the precompiled headers are no longer parsed,
+        // the saving isn't measured, that would require parsing the file again without it,
+        // it is estimated as the time it took to build the preamble
+        logger_->debug("parsed '{}' in {}ms using the preamble, estimated saving {}ms "
+                       "(build time of the preamble)",
+                       file_name, get_milliseconds(begin), preamble->build_time);
+        file_ptr->preamble_ = preamble;
+        file_ptr->dependencies_.insert(file_ptr->dependencies_.end(),
+                                       preamble->dependencies.begin(),
+                                       preamble->dependencies.end());
+    }
+    file_ptr->unit_ = std::make_shared<detail::tu_wrapper>(tu);
     file_ptr->set_cursor(clang_getTranslationUnitCursor(tu));
 
-    return translation_unit(*this, full_path, file_ptr);
+    {
+        profile_timer timer(profiler_, file_name, profile_phase::directives);
+        // tokenize once, the macros and entities only take slices of it
+        file_ptr->tokens_ =
+            detail::token_buffer(tu, clang_getFile(tu, full_path), unsigned(source.size()));
+        preprocessor_.process_directives(*this, c, tu, full_path, *file_ptr, source);
+    }
+
+    std::vector<detail::raw_comment> comments;
+    {
+        profile_timer timer(profiler_, file_name, profile_phase::comments);
+        comments = detail::read_comments(source);
+        parse_comments(*this, file_name, comments);
+    }
+
+    // the entities are parsed by the translation unit
+    profile_timer timer(profiler_, file_name, profile_phase::entities);
+    return translation_unit(*this, full_path, file_ptr, std::move(comments));
+}
+
+std::vector<translation_unit> parser::parse_unity(const std::vector<std::string>& full_paths,
+                                                  const compile_config&           c,
+                                                  const std::vector<std::string>& file_names) const
+{
+    namespace fs = boost::filesystem;
+
+    assert(file_names.empty() || file_names.size() == full_paths.size());
+    if (full_paths.empty())
+        return {};
+
+    // the files aren't preprocessed on their own,
+    // so the directives must be taken from the translation unit
+    auto config = c;
+    config.set_preprocessor_backend(preprocessor_backend::in_process);
+
+    // the files share an arena, like the translation unit
+    auto arena = std::make_shared<detail::entity_arena>();
+
+    std::vector<cpp_file*>   file_ptrs;
+    std::vector<std::string> sources;
+    std::string              unity;
+    for (auto i = 0u; i != full_paths.size(); ++i)
+    {
+        auto&             file_name = file_names.empty() ? full_paths[i] : file_names[i];
+        cpp_ptr<cpp_file> file(new cpp_file(file_name));
+        file->arena_ = arena;
+        file_ptrs.push_back(file.get());
+        files_.add_file(std::move(file));
+
+        detail::entity_arena_scope<cpp_entity> file_arena(arena.get());
+
+        profile_timer timer(profiler_, file_name, profile_phase::preprocess);
+        sources.push_back(
+            preprocessor_.preprocess(*this, config, full_paths[i].c_str(), *file_ptrs.back()));
+        timer.set_bytes(sources.back().size());
+        unity += "#include \"" + fs::system_complete(full_paths[i]).generic_string() + "\"\n";
+    }
+
+    // the unity file doesn't exist on disk
+    auto unity_path = (fs::current_path() / "standardese-unity.cpp").generic_string();
+    std::vector<CXUnsavedFile> files{make_unsaved_file(unity_path.c_str(), unity)};
+    for (auto i = 0u; i != full_paths.size(); ++i)
+        files.push_back(make_unsaved_file(full_paths[i].c_str(), sources[i]));
+
+    auto preamble = get_preamble(config);
+    auto begin    = std::chrono::steady_clock::now();
+    auto tu       = [&] {
+        profile_timer timer(profiler_, unity_path.c_str(), profile_phase::parse);
+        return get_cxunit(logger_, index_.get(), config, unity_path.c_str(), files,
+                          preamble.get());
+    }();
+    auto unit = std::make_shared<detail::tu_wrapper>(tu);
+    logger_->debug("parsed {} files in unity mode in {}ms", full_paths.size(),
+                   get_milliseconds(begin));
+
+    detail::entity_arena_scope<cpp_entity> unity_arena(arena.get());
+
+    std::vector<translation_unit> result;
+    result.reserve(full_paths.size());
+    for (auto i = 0u; i != full_paths.size(); ++i)
+    {
+        auto& file = *file_ptrs[i];
+        file.unit_ = unit;
+        file.set_cursor(clang_getTranslationUnitCursor(tu));
+
+        // use the file name as libclang sees it,
+        // as the entities are filtered by the name of their location
+        auto        cxfile = clang_getFile(tu, full_paths[i].c_str());
+        std::string path   = cxfile ? string(clang_getFileName(cxfile)).c_str() : full_paths[i];
+
+        file.preamble_ = preamble;
+        if (preamble)
+            file.dependencies_ = preamble->dependencies;
+        {
+            profile_timer timer(profiler_, file.get_name().c_str(), profile_phase::directives);
+            if (cxfile)
+                file.tokens_ = detail::token_buffer(tu, cxfile, unsigned(sources[i].size()));
+            preprocessor_.process_directives(*this, config, tu, path.c_str(), file, sources[i]);
+        }
+
+        std::vector<detail::raw_comment> comments;
+        {
+            profile_timer timer(profiler_, file.get_name().c_str(), profile_phase::comments);
+            comments = detail::read_comments(sources[i]);
+            parse_comments(*this, file.get_name().c_str(), comments);
+        }
+
+        profile_timer timer(profiler_, file.get_name().c_str(), profile_phase::entities);
+
+        result.push_back(translation_unit(*this, path.c_str(), &file, std::move(comments)));
+    }
+
+    return result;
 }
 
 parser::parser(std::shared_ptr<spdlog::logger> logger)
-: index_(clang_createIndex(1, 0)), logger_(std::move(logger))
+: index_(clang_createIndex(1, 0)), logger_(std::move(logger)), profiler_(nullptr)
 {
 }
 
@@ -0,0 +1,69 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include <standardese/profiler.hpp>
+
+#include <cstdint>
+#include <ctime>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+using namespace standardese;
+
+const char* standardese::get_phase_name(profile_phase phase) STANDARDESE_NOEXCEPT
+{
+    switch (phase)
+    {
+    case profile_phase::preprocess:
+        return "preprocess";
+    case profile_phase::parse:
+        return "parse";
+    case profile_phase::directives:
+        return "directives";
+    case profile_phase::comments:
+        return "comments";
+    case profile_phase::entities:
+        return "entities";
+    case profile_phase::generate:
+        return "generate";
+    case profile_phase::render:
+        return "render";
+    case profile_phase::write:
+        return "write";
+    case profile_phase::lock_wait:
+        return "lock_wait";
+
+    case profile_phase::count:
+        break;
+    }
+
+    return "unknown";
+}
+
+double standardese::get_thread_cpu_time() STANDARDESE_NOEXCEPT
+{
+#if defined(_WIN32)
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+        return 0.0;
+
+    auto to_seconds = [](const FILETIME& t) {
+        // in units of 100ns
+        return double((std::uint64_t(t.dwHighDateTime) << 32u) | t.dwLowDateTime) * 1e-7;
+    };
+    return to_seconds(kernel) + to_seconds(user);
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec t;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t) != 0)
+        return 0.0;
+    return double(t.tv_sec) + double(t.tv_nsec) * 1e-9;
+#else
+    // fall back to the CPU time of the process
+    return double(std::clock()) / CLOCKS_PER_SEC;
+#endif
+}
@@ -0,0 +1,85 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include <standardese/string_table.hpp>
+
+using namespace standardese;
+
+const detail::string_atom* detail::string_atom::create(const char* str, std::size_t length,
+                                                       const void* table)
+{
+    auto memory = ::operator new(sizeof(string_atom) + length + 1u);
+    auto atom   = ::new (memory) string_atom(length, hash_string(str, length), table);
+
+    auto chars = static_cast<char*>(memory) + sizeof(string_atom);
+    std::memcpy(chars, str, length);
+    chars[length] = '\0';
+
+    return atom;
+}
+
+void detail::string_atom::release() const STANDARDESE_NOEXCEPT
+{
+    if (refs_.fetch_sub(1u, std::memory_order_acq_rel) == 1u)
+    {
+        this->~string_atom();
+        ::operator delete(const_cast<string_atom*>(this));
+    }
+}
+
+const std::size_t string_table::shard_count;
+
+string_table::~string_table() STANDARDESE_NOEXCEPT
+{
+    for (auto& shard : shards_)
+        for (auto& pair : shard.map)
+            pair.second->release();
+}
+
+string string_table::intern(const char* str, std::size_t length) const
+{
+    auto  hash  = detail::hash_string(str, length);
+    auto& shard = get_shard(hash);
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto                        range = shard.map.equal_range(hash);
+    for (auto iter = range.first; iter != range.second; ++iter)
+    {
+        auto atom = iter->second;
+        if (atom->length() == length && std::memcmp(atom->c_str(), str, length) == 0)
+            return string(*atom);
+    }
+
+    // the table keeps the reference of create()
+    auto atom = detail::string_atom::create(str, length, this);
+    try
+    {
+        shard.map.emplace(hash, atom);
+    }
+    catch (...)
+    {
+        atom->release();
+        throw;
+    }
+    return string(*atom);
+}
+
+string string_table::intern(const string& str) const
+{
+    auto atom = str.get_atom();
+    if (atom && atom->get_table() == this)
+        return str;
+    return intern(str.c_str(), str.length());
+}
+
+std::size_t string_table::size() const STANDARDESE_NOEXCEPT
+{
+    std::size_t result = 0u;
+    for (auto& shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        result += shard.map.size();
+    }
+    return result;
+}
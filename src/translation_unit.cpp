@@ -55,6 +55,18 @@ const cpp_entity_registry& translation_unit::get_registry() const STANDARDESE_NO
     return parser_->get_entity_registry();
 }
 
+std::size_t translation_unit::get_memory_usage() const
+{
+    auto usage = clang_getCXTUResourceUsage(get_cxunit());
+
+    std::size_t result = 0u;
+    for (auto i = 0u; i != usage.numEntries; ++i)
+        result += std::size_t(usage.entries[i].amount);
+
+    clang_disposeCXTUResourceUsage(usage);
+    return result + get_file().get_tokens().get_memory_usage();
+}
+
 namespace
 {
     bool handle_cursor(cpp_cursor cur)
@@ -71,10 +83,12 @@ namespace
     }
 }
 
-translation_unit::translation_unit(const parser& par, const char* path, cpp_file* file)
-: full_path_(path), file_(file), parser_(&par)
+translation_unit::translation_unit(const parser& par, const char* path, cpp_file* file,
+                                   std::vector<detail::raw_comment> comments)
+: comments_(std::move(comments)), full_path_(path), file_(file), parser_(&par)
 {
-    detail::scope_stack stack(file_);
+    detail::scope_stack            stack(file_);
+    std::vector<const cpp_entity*> parsed;
 
     detail::visit_tu(get_cxunit(), path, [&](cpp_cursor cur, cpp_cursor parent) {
         stack.pop_if_needed(parent);
@@ -103,8 +117,7 @@ translation_unit::translation_unit(const parser& par, const char* path, cpp_file
             if (!entity)
                 return CXChildVisit_Continue;
 
-            get_parser().get_entity_registry().register_entity(*entity);
-
+            parsed.push_back(entity.get());
             auto container = stack.add_entity(std::move(entity), parent);
             if (container)
                 return CXChildVisit_Recurse;
@@ -126,4 +139,14 @@ translation_unit::translation_unit(const parser& par, const char* path, cpp_file
             return CXChildVisit_Continue;
         }
     });
+
+    // the entities are only registered once their names and locations are cached,
+    // so other files never need their cursors, which dangle once the unit is released
+    for (auto entity : parsed)
+    {
+        entity->get_name();
+        if (!is_preprocessor(entity->get_entity_type()))
+            entity->get_presumed_location();
+        get_parser().get_entity_registry().register_entity(*entity);
+    }
 }
@@ -121,6 +121,33 @@ TEST_CASE("md_comment", "[doc]")
         REQUIRE(comments[9].count_lines == 2u);
         REQUIRE(comments[9].end_line == 28u);
     }
+    SECTION("line directives")
+    {
+        auto source = R"(int a_declaration_that_is_longer_than_a_block_of_characters;
+#line 42
+/// After <directive>.
+int b; /**< Not a C++ comment but a long line: a / b / c. */
+
+/** Multiline
+    with a slash at the end /
+    **/
+)";
+
+        auto comments = detail::read_comments(source);
+        REQUIRE(comments.size() == 3);
+
+        REQUIRE(comments[0].content == "After \\<directive\\>.");
+        REQUIRE(comments[0].count_lines == 1u);
+        REQUIRE(comments[0].end_line == 42u);
+
+        REQUIRE(comments[1].content == "\\< Not a C++ comment but a long line: a / b / c.");
+        REQUIRE(comments[1].count_lines == 1u);
+        REQUIRE(comments[1].end_line == 43u);
+
+        REQUIRE(comments[2].content == "Multiline\nwith a slash at the end \\");
+        REQUIRE(comments[2].count_lines == 3u);
+        REQUIRE(comments[2].end_line == 47u);
+    }
     SECTION("simple parsing")
     {
         auto& comment = parse_comment(p, R"(/// Hello World.)");
@@ -73,3 +73,36 @@ TEST_CASE("cpp_entity", "[cpp]")
     REQUIRE(last == container.end());
     REQUIRE(!container.empty());
 }
+
+TEST_CASE("cpp_entity_names", "[cpp]")
+{
+    struct test_entity : cpp_entity
+    {
+        mutable unsigned count = 0u;
+
+        test_entity() : cpp_entity(class_t, {})
+        {
+        }
+
+        cpp_name get_name() const override
+        {
+            ++count;
+            return "a";
+        }
+    };
+
+    test_entity e;
+    auto        before = detail::get_name_statistics();
+
+    REQUIRE(e.get_unique_name() == "a");
+    REQUIRE(e.get_unique_name() == "a");
+    REQUIRE(e.get_full_name() == "a");
+    REQUIRE(e.get_full_name() == "a");
+    // once for the unique name, once for the full name
+    REQUIRE(e.count == 2u);
+
+    auto after = detail::get_name_statistics();
+    // the scoped unique name is computed from the unscoped one
+    REQUIRE(after.computed - before.computed == 3u);
+    REQUIRE(after.cached - before.cached == 2u);
+}
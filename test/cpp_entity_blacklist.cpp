@@ -322,3 +322,43 @@ enum_
         REQUIRE(get_synopsis(tu) == synopsis);
     }
 }
+
+TEST_CASE("synopsis_unresolved_reference")
+{
+    parser p(test_logger);
+    p.get_external_linker().register_external("ext::", "https://ext.example/$$");
+
+    auto code = R"(
+namespace ext
+{
+    struct a;
+}
+
+namespace other
+{
+    struct b;
+}
+
+void f(ext::a* x, other::b* y);
+)";
+
+    auto               tu = parse(p, "synopsis_unresolved_reference", code);
+    standardese::index i;
+    auto               file = doc_file::parse(p, i, "", tu.get_file());
+
+    const doc_entity* f = nullptr;
+    for (auto& e : *file)
+        if (e.get_name() == "f")
+            f = &e;
+    REQUIRE(f);
+
+    auto              doc = md_document::make("");
+    code_block_writer cb(*doc, true);
+    f->generate_synopsis(p, cb);
+    std::string synopsis = static_cast<md_leave&>(*cb.get_code_block()).get_string();
+
+    // a type that isn't documented has an empty unique name, so it is looked up externally
+    REQUIRE(synopsis.find("<a href='https://ext.example/") != std::string::npos);
+    // and it isn't linked if there is no external documentation either
+    REQUIRE(synopsis.find("standardese:///'") == std::string::npos);
+}
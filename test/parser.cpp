@@ -0,0 +1,304 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include <standardese/parser.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iterator>
+
+#include <standardese/detail/tokenizer.hpp>
+#include <standardese/generator.hpp>
+#include <standardese/index.hpp>
+#include <standardese/md_blocks.hpp>
+#include <standardese/output.hpp>
+
+#include <catch.hpp>
+
+#include "test_parser.hpp"
+
+using namespace standardese;
+
+namespace
+{
+    void write_file(const char* name, const char* code)
+    {
+        std::ofstream file(name);
+        file << code;
+    }
+
+    std::vector<std::string> get_names(const translation_unit& tu)
+    {
+        std::vector<std::string> result;
+        for_each(tu.get_file(), [&](const cpp_entity& e) { result.push_back(e.get_name().c_str()); });
+        return result;
+    }
+}
+
+TEST_CASE("parse_unity", "[cpp]")
+{
+    parser p(test_logger);
+
+    write_file("parse_unity_header.hpp", R"(
+        #pragma once
+
+        /// shared
+        struct shared {};
+    )");
+    write_file("parse_unity_a.cpp", R"(
+        #include "parse_unity_header.hpp"
+
+        /// a
+        struct a : shared {};
+    )");
+    write_file("parse_unity_b.cpp", R"(
+        #include "parse_unity_header.hpp"
+
+        #define B
+
+        /// b
+        void b(shared s);
+    )");
+
+    auto tus = p.parse_unity({"parse_unity_a.cpp", "parse_unity_b.cpp"}, get_compile_config());
+    REQUIRE(tus.size() == 2u);
+
+    REQUIRE(tus[0].get_file().get_name() == "parse_unity_a.cpp");
+    REQUIRE(get_names(tus[0]) == (std::vector<std::string>{"inclusion directive", "a"}));
+
+    REQUIRE(tus[1].get_file().get_name() == "parse_unity_b.cpp");
+    REQUIRE(get_names(tus[1]) == (std::vector<std::string>{"inclusion directive", "B", "b"}));
+}
+
+TEST_CASE("detach_doc_file", "[cpp]")
+{
+    parser p(test_logger);
+    index  idx;
+
+    auto tu  = parse(p, "detach_doc_file.cpp", R"(
+        /// a
+        struct a
+        {
+            /// f
+            void f(int i) const;
+        };
+    )");
+    auto doc = generate_doc_file(p, idx, tu.get_file(), "detach_doc_file");
+    REQUIRE(doc.file);
+
+    detach_doc_file(doc);
+    tu.get_file().release_cxunit();
+    REQUIRE(tu.get_cxunit() == nullptr);
+
+    // the names are still available
+    auto& a = *doc.file->begin();
+    REQUIRE(a.get_name() == "a");
+    REQUIRE(a.get_unique_name() == "a");
+    REQUIRE(a.get_index_name(true, true) == "a");
+
+    auto& f = *a.begin();
+    REQUIRE(f.get_name() == "f");
+    REQUIRE(f.get_unique_name() == "a::f(int) const");
+    REQUIRE(f.get_index_name(true, true) == "a::f(int) const");
+}
+
+TEST_CASE("detach_doc_file cross reference", "[cpp]")
+{
+    parser p(test_logger);
+    p.get_output_config().set_hidden_name("hidden");
+    index idx;
+
+    auto get_synopsis = [&](const doc_entity& e) {
+        auto              doc = md_document::make("");
+        code_block_writer cb(*doc, false);
+        e.generate_synopsis(p, cb);
+        return static_cast<md_code_block&>(*cb.get_code_block()).get_string();
+    };
+
+    // both files reference the other one
+    auto tu_a  = parse(p, "detach_cross_a.hpp", R"(
+        struct b;
+
+        /// \exclude
+        struct a {};
+
+        /// f
+        void f(const b& y);
+    )");
+    auto doc_a = generate_doc_file(p, idx, tu_a.get_file(), "detach_cross_a");
+    REQUIRE(doc_a.file);
+    detach_doc_file(doc_a);
+    tu_a.get_file().release_cxunit();
+
+    auto tu_b  = parse(p, "detach_cross_b.hpp", R"(
+        struct a;
+
+        /// b
+        struct b {};
+
+        /// g
+        void g(const a& x);
+    )");
+    auto doc_b = generate_doc_file(p, idx, tu_b.get_file(), "detach_cross_b");
+    REQUIRE(doc_b.file);
+
+    // a is found in the registry, its comment is looked up without the released unit
+    auto iter = std::find_if(doc_b.file->begin(), doc_b.file->end(),
+                             [](const doc_entity& e) { return e.get_name() == "g"; });
+    REQUIRE(iter != doc_b.file->end());
+    REQUIRE(get_synopsis(*iter).find("hidden") != std::string::npos);
+}
+
+TEST_CASE("parser_profiler", "[cpp]")
+{
+    struct test_profiler : profiler
+    {
+        std::vector<profile_event> events;
+
+        void do_record(const profile_event& e) override
+        {
+            events.push_back(e);
+        }
+    } prof;
+
+    parser p(test_logger);
+    p.set_profiler(&prof);
+    parse(p, "parser_profiler.cpp", R"(
+        /// a
+        struct a {};
+    )");
+    p.set_profiler(nullptr);
+
+    auto count = [&](profile_phase phase) {
+        return std::count_if(prof.events.begin(), prof.events.end(),
+                             [&](const profile_event& e) { return e.phase == phase; });
+    };
+    REQUIRE(count(profile_phase::preprocess) == 1);
+    REQUIRE(count(profile_phase::parse) == 1);
+    REQUIRE(count(profile_phase::directives) == 1);
+    REQUIRE(count(profile_phase::comments) == 1);
+    REQUIRE(count(profile_phase::entities) == 1);
+
+    for (auto& e : prof.events)
+    {
+        REQUIRE(e.file == "parser_profiler.cpp");
+        REQUIRE(e.begin <= e.end);
+        if (e.phase == profile_phase::preprocess)
+            REQUIRE(e.bytes > 0u);
+    }
+}
+
+TEST_CASE("token_buffer", "[cpp]")
+{
+    parser p(test_logger);
+    auto   tu = parse(p, "token_buffer.cpp", R"(
+        #define MACRO(x) ((x) >> 1)
+
+        /// a
+        template <typename T, typename U = decltype(T())>
+        struct a
+        {
+            void f(int i, const char* c = "// not a comment") const;
+
+            a& operator>>(int) { return *this; }
+        };
+
+        using b = a<a<int>>;
+    )");
+
+    auto& buffer = tu.get_file().get_tokens();
+    REQUIRE(!buffer.empty());
+
+    auto get_spellings = [](const detail::tokenizer& tokenizer) {
+        std::vector<std::string> result;
+        for (auto token : tokenizer)
+            result.push_back(token.get_value().c_str());
+        return result;
+    };
+
+    // slices of the buffer have the same tokens as tokenizing the entity on its own
+    detail::visit_tu(tu.get_cxunit(), tu.get_path().c_str(), [&](CXCursor cur, CXCursor) {
+        auto kind = clang_getCursorKind(cur);
+        if (!clang_isDeclaration(kind) && kind != CXCursor_MacroDefinition)
+            return CXChildVisit_Continue;
+
+        detail::tokenizer sliced(tu.get_cxunit(), tu.get_cxfile(), cur, &buffer);
+        detail::tokenizer tokenized(tu.get_cxunit(), tu.get_cxfile(), cur);
+        REQUIRE(get_spellings(sliced) == get_spellings(tokenized));
+        if (kind == CXCursor_TemplateTypeParameter)
+            REQUIRE(sliced.need_unmunch() == tokenized.need_unmunch());
+        return CXChildVisit_Recurse;
+    });
+
+    tu.get_file().release_cxunit();
+    REQUIRE(tu.get_file().get_tokens().empty());
+}
+
+TEST_CASE("string_table", "[cpp]")
+{
+    parser p(test_logger);
+    auto&  strings = p.get_string_table();
+
+    auto a = strings.intern("foo");
+    auto b = strings.intern(std::string("foo").c_str(), 3u);
+    REQUIRE(a.get_atom() == b.get_atom());
+    REQUIRE(a == b);
+    REQUIRE(a.hash() == cpp_name("foo").hash());
+    REQUIRE(strings.intern(a).get_atom() == a.get_atom());
+
+    // the length of a literal doesn't include the null terminator
+    cpp_name literal("foo");
+    REQUIRE(literal.length() == 3u);
+    REQUIRE(cpp_name("").empty());
+    REQUIRE(strings.intern(literal).get_atom() == a.get_atom());
+
+    auto c = strings.intern("bar");
+    REQUIRE(a != c);
+    REQUIRE(strings.size() == 2u);
+
+    // copies share the characters
+    cpp_name copy(a);
+    REQUIRE(copy.get_atom() == a.get_atom());
+    REQUIRE(copy == "foo");
+
+    // names of entities are shared as well
+    auto tu = parse(p, "string_table.cpp", "struct foo {};");
+    for_each(tu.get_file(), [&](const cpp_entity& e) {
+        auto name = e.get_unique_name();
+        REQUIRE(name.get_atom());
+        REQUIRE(name.get_atom() == e.get_unique_name().get_atom());
+        REQUIRE(name == a);
+    });
+}
+
+TEST_CASE("entity_arena", "[cpp]")
+{
+    parser p(test_logger);
+    index  idx;
+
+    auto tu = parse(p, "entity_arena.cpp", R"(
+        /// a
+        struct a {};
+        /// b
+        struct b {};
+        /// c
+        struct c {};
+    )");
+    REQUIRE(detail::entity_arena_scope<cpp_entity>::get() == nullptr);
+
+    // the entities are allocated in the order they are parsed
+    const cpp_entity* last = nullptr;
+    for (auto& e : tu.get_file())
+    {
+        if (last)
+            REQUIRE(std::less<const cpp_entity*>()(last, &e));
+        last = &e;
+    }
+    REQUIRE(last);
+
+    auto file = doc_file::parse(p, idx, "entity_arena", tu.get_file());
+    REQUIRE(detail::entity_arena_scope<doc_entity>::get() == nullptr);
+    REQUIRE(std::distance(file->begin(), file->end()) == 3);
+}
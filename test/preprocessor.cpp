@@ -6,6 +6,7 @@
 
 #include <catch.hpp>
 
+#include <standardese/detail/friend_rewriter.hpp>
 #include <standardese/doc_entity.hpp>
 
 #include "test_parser.hpp"
@@ -34,7 +35,17 @@ TEST_CASE("cpp_macro_definition", "[cpp]")
         struct test {};
     )";
 
-    auto tu = parse(p, "cpp_preprocessor", code);
+    auto config = get_compile_config();
+    SECTION("external")
+    {
+        config.set_preprocessor_backend(preprocessor_backend::external);
+    }
+    SECTION("in-process")
+    {
+        config.set_preprocessor_backend(preprocessor_backend::in_process);
+    }
+
+    auto tu = parse(p, "cpp_preprocessor", code, config);
 
     auto count = 0u;
     for (auto& e : tu.get_file())
@@ -88,3 +99,80 @@ TEST_CASE("cpp_macro_definition", "[cpp]")
     }
     REQUIRE(count == 6u);
 }
+
+TEST_CASE("in-process preprocessor without final newline", "[cpp]")
+{
+    parser p(test_logger);
+    auto   config = get_compile_config();
+    config.set_preprocessor_backend(preprocessor_backend::in_process);
+
+    auto tu = parse(p, "cpp_preprocessor_no_newline", "/// a\nstruct a {};", config);
+    auto count = 0u;
+    for (auto& e : tu.get_file())
+    {
+        REQUIRE(e.get_name() == "a");
+        REQUIRE(p.get_comment_registry().lookup_comment(e, nullptr) != nullptr);
+        ++count;
+    }
+    REQUIRE(count == 1u);
+
+    auto empty = parse(p, "cpp_preprocessor_empty", "", config);
+    REQUIRE(empty.get_file().begin() == empty.get_file().end());
+}
+
+TEST_CASE("friend_rewriter", "[cpp]")
+{
+    auto code = R"(struct foo
+{
+    friend void a();
+    friend void b() {}
+    friend bool operator==(foo, foo) noexcept(noexcept(foo{})) { return true; }
+    friend class bar;
+
+    // friend void c() {}
+    /* friend void d() {} */
+    const char* e = "friend void e() {}";
+    void befriend() {}
+    int f = 1'000;
+    friend void g() /* ; */ {}
+};
+)";
+
+    auto expected = R"(struct foo
+{
+    friend void a();
+    __standardese_friend void b() {}
+    __standardese_friend bool operator==(foo, foo) noexcept(noexcept(foo{})) { return true; }
+    friend class bar;
+
+    // friend void c() {}
+    /* friend void d() {} */
+    const char* e = "friend void e() {}";
+    void befriend() {}
+    int f = 1'000;
+    __standardese_friend void g() /* ; */ {}
+};
+)";
+
+    SECTION("complete source")
+    {
+        std::string source = code;
+        detail::rewrite_friend_definitions(source);
+        REQUIRE(source == expected);
+    }
+    SECTION("appended in pieces")
+    {
+        std::string             source;
+        detail::friend_rewriter rewriter(source);
+        for (auto ptr = code; *ptr; ++ptr)
+        {
+            // splits every keyword and comment
+            source += *ptr;
+            rewriter.rewrite();
+        }
+        rewriter.finish();
+
+        REQUIRE(rewriter.get_definition_count() == 3u);
+        REQUIRE(source == expected);
+    }
+}
@@ -27,13 +27,20 @@ inline standardese::compile_config get_compile_config()
 }
 
 inline standardese::translation_unit parse(standardese::parser& p, const char* name,
-                                           const char* code)
+                                           const char* code,
+                                           const standardese::compile_config& c)
 {
     std::ofstream file(name);
     file << code;
     file.close();
 
-    return p.parse(name, get_compile_config());
+    return p.parse(name, c);
+}
+
+inline standardese::translation_unit parse(standardese::parser& p, const char* name,
+                                           const char* code)
+{
+    return parse(p, name, code, get_compile_config());
 }
 
 template <typename T>
@@ -0,0 +1,709 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_CACHE_HPP_INCLUDED
+#define STANDARDESE_CACHE_HPP_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <cmark.h>
+#include <spdlog/fmt/fmt.h>
+
+#include <standardese/detail/raw_comment.hpp>
+#include <standardese/comment.hpp>
+#include <standardese/doc_entity.hpp>
+#include <standardese/generator.hpp>
+#include <standardese/index.hpp>
+#include <standardese/md_blocks.hpp>
+#include <standardese/output.hpp>
+#include <standardese/parser.hpp>
+#include <standardese/section.hpp>
+
+namespace standardese_tool
+{
+    namespace fs = boost::filesystem;
+
+    namespace detail
+    {
+        // 64bit FNV-1a
+        class hash
+        {
+        public:
+            hash() STANDARDESE_NOEXCEPT : value_(14695981039346656037ull)
+            {
+            }
+
+            hash& append(const char* str, std::size_t n) STANDARDESE_NOEXCEPT
+            {
+                for (auto end = str + n; str != end; ++str)
+                {
+                    value_ ^= static_cast<unsigned char>(*str);
+                    value_ *= 1099511628211ull;
+                }
+                return *this;
+            }
+
+            hash& append(const std::string& str) STANDARDESE_NOEXCEPT
+            {
+                // include the terminator, so "ab" + "c" != "a" + "bc"
+                return append(str.c_str(), str.size() + 1);
+            }
+
+            std::uint64_t value() const STANDARDESE_NOEXCEPT
+            {
+                return value_;
+            }
+
+            std::string str() const
+            {
+                return fmt::format("{:016x}", value_);
+            }
+
+        private:
+            std::uint64_t value_;
+        };
+
+        inline bool read_file(const fs::path& p, std::string& result)
+        {
+            std::ifstream file(p.string(), std::ios_base::binary);
+            if (!file.is_open())
+                return false;
+            result.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>{});
+            return true;
+        }
+
+        // whether the text uses the command that documents an entity of another file
+        inline bool has_entity_command(const std::string&                 text,
+                                       const standardese::comment_config& config)
+        {
+            auto cmd_char = config.get_command_character();
+            for (auto pos = text.find(cmd_char); pos != std::string::npos;
+                 pos      = text.find(cmd_char, pos + 1u))
+            {
+                auto end = pos + 1u;
+                while (end != text.size()
+                       && (std::isalnum(static_cast<unsigned char>(text[end])) || text[end] == '_'))
+                    ++end;
+                if (config.try_get_command(text.substr(pos + 1u, end - pos - 1u))
+                    == unsigned(standardese::command_type::entity))
+                    return true;
+            }
+            return false;
+        }
+
+        // format: <length>:<data>
+        inline void write_string(std::ostream& out, const std::string& str)
+        {
+            out << str.size() << ':';
+            out.write(str.data(), static_cast<std::streamsize>(str.size()));
+        }
+
+        inline void write_number(std::ostream& out, std::uint64_t n)
+        {
+            out << n << ':';
+        }
+
+        class entry_reader
+        {
+        public:
+            explicit entry_reader(const std::string& data) STANDARDESE_NOEXCEPT
+            : cur_(data.c_str()),
+              end_(data.c_str() + data.size())
+            {
+            }
+
+            std::uint64_t read_number()
+            {
+                std::uint64_t result = 0u;
+                while (cur_ != end_ && *cur_ != ':')
+                {
+                    if (*cur_ < '0' || *cur_ > '9')
+                        throw std::runtime_error("invalid cache entry");
+                    result = result * 10u + std::uint64_t(*cur_ - '0');
+                    ++cur_;
+                }
+                if (cur_ == end_)
+                    throw std::runtime_error("invalid cache entry");
+                ++cur_;
+                return result;
+            }
+
+            std::string read_string()
+            {
+                auto size = read_number();
+                if (std::uint64_t(end_ - cur_) < size)
+                    throw std::runtime_error("invalid cache entry");
+                std::string result(cur_, std::size_t(size));
+                cur_ += size;
+                return result;
+            }
+
+        private:
+            const char *cur_, *end_;
+        };
+
+        // owns the comment of a cached_entity
+        // must be a base, so that it is initialized before doc_entity
+        class comment_holder
+        {
+        protected:
+            comment_holder() : comment_(new standardese::comment)
+            {
+            }
+
+            std::unique_ptr<standardese::comment> comment_;
+        };
+
+        inline void add_parsed_children(standardese::md_container& parent, cmark_node* node)
+        {
+            for (auto child = cmark_node_first_child(node); child; child = cmark_node_next(child))
+            {
+                auto entity = standardese::md_entity::try_parse(child, parent);
+                if (standardese::is_container(entity->get_entity_type()))
+                    add_parsed_children(static_cast<standardese::md_container&>(*entity), child);
+                parent.add_entity(std::move(entity));
+            }
+        }
+    } // namespace detail
+
+    // information about a doc_entity needed for the index and linking
+    struct cached_entity_info
+    {
+        std::string                  name, unique_name, brief, module, anchor_id;
+        std::string                  index_names[4]; // [full_name * 2 + signature]
+        std::size_t                  parent; // index into vector, or npos
+        standardese::doc_entity::type doc_type;
+        standardese::cpp_entity::type cpp_type;
+        bool                         registered;
+    };
+
+    // a doc_entity that is restored from the cache
+    // it only has the information required to be in the index
+    class cached_entity final : private detail::comment_holder, public standardese::doc_entity
+    {
+    public:
+        cached_entity(const cached_entity_info& info, const standardese::doc_entity* parent)
+        : doc_entity(info.doc_type, parent, comment_.get()), info_(&info)
+        {
+            // uses the unique name override to reproduce the unique name without the entity
+            comment_->set_unique_name_override(info.unique_name);
+            if (!info.module.empty())
+                comment_->set_module(info.module);
+
+            if (!info.brief.empty())
+            {
+                auto& brief = comment_->get_content().get_brief();
+                auto  document =
+                    cmark_parse_document(info.brief.c_str(), info.brief.size(), CMARK_OPT_DEFAULT);
+                if (auto paragraph = cmark_node_first_child(document))
+                    detail::add_parsed_children(brief, paragraph);
+                cmark_node_free(document);
+            }
+        }
+
+    protected:
+        void do_generate_documentation(const standardese::parser&, const standardese::index&,
+                                       standardese::md_document&, unsigned) const override
+        {
+        }
+
+        void do_generate_synopsis(const standardese::parser&, standardese::code_block_writer&,
+                                  bool) const override
+        {
+        }
+
+    private:
+        standardese::cpp_name do_get_name() const override
+        {
+            return info_->name;
+        }
+
+        standardese::cpp_name do_get_unique_name() const override
+        {
+            return info_->unique_name;
+        }
+
+        standardese::cpp_name do_get_index_name(bool full_name, bool signature) const override
+        {
+            return info_->index_names[(full_name ? 2 : 0) + (signature ? 1 : 0)];
+        }
+
+        standardese::cpp_entity::type do_get_cpp_entity_type() const STANDARDESE_NOEXCEPT override
+        {
+            return info_->cpp_type;
+        }
+
+        const cached_entity_info* info_;
+    };
+
+    // the generation result of a single file
+    struct cache_entry
+    {
+        std::string file_name, output_name;
+        std::vector<std::pair<std::string, std::string>> dependencies; // path, hash
+        std::vector<standardese::detail::raw_comment>    comments;
+        std::vector<cached_entity_info>                  entities;
+        std::map<std::string, standardese::raw_document> documents; // by format extension
+
+        // restored entities, they must live as long as the index
+        std::vector<std::unique_ptr<cached_entity>> restored;
+    };
+
+    // persistent cache of the documentation of unchanged files
+    class file_cache
+    {
+    public:
+        static std::size_t npos() STANDARDESE_NOEXCEPT
+        {
+            return std::size_t(-1);
+        }
+
+        // fingerprint describes everything that influences the output besides the file itself
+        file_cache(fs::path dir, std::uintmax_t max_size, std::string fingerprint)
+        : dir_(std::move(dir)),
+          fingerprint_(std::move(fingerprint)),
+          max_size_(max_size),
+          hits_(0u),
+          misses_(0u),
+          stored_(0u),
+          pruned_(0u)
+        {
+            fs::create_directories(dir_);
+
+            // remove the temporary files of writes that were interrupted
+            std::vector<fs::path> tmp_files;
+            for (fs::directory_iterator iter(dir_), end; iter != end; ++iter)
+                if (iter->path().extension() == ".tmp")
+                    tmp_files.push_back(iter->path());
+            for (auto& file : tmp_files)
+            {
+                boost::system::error_code ec;
+                fs::remove(file, ec);
+            }
+        }
+
+        // comments with the entity command can document entities of other files,
+        // so the files containing them are part of the key of every entry
+        // must be called before the first lookup()
+        void add_remote_comments(std::vector<fs::path>              source_files,
+                                 const standardese::comment_config& config)
+        {
+            std::sort(source_files.begin(), source_files.end());
+
+            detail::hash h;
+            auto         any = false;
+            for (auto& file : source_files)
+            {
+                std::string content;
+                if (detail::read_file(file, content) && detail::has_entity_command(content, config))
+                {
+                    h.append(fs::system_complete(file).generic_string())
+                        .append(detail::hash().append(content).str());
+                    any = true;
+                }
+            }
+
+            if (any)
+                fingerprint_ += "\nremote comments " + h.str();
+        }
+
+        // returns the valid entry for the given file, if there is any
+        std::unique_ptr<cache_entry> lookup(const fs::path& path)
+        {
+            auto entry_path = get_entry_path(path);
+
+            std::unique_ptr<cache_entry> result;
+            std::string                  data;
+            if (detail::read_file(entry_path, data))
+            {
+                try
+                {
+                    result = read_entry(data);
+                }
+                catch (std::exception&)
+                {
+                    result = nullptr;
+                }
+            }
+
+            if (!result || !is_valid(path, *result))
+            {
+                ++misses_;
+                return nullptr;
+            }
+
+            ++hits_;
+            // keep recently used entries when pruning
+            boost::system::error_code ec;
+            fs::last_write_time(entry_path, std::time(nullptr), ec);
+            return result;
+        }
+
+        // restores the index registrations and comments of an entry
+        void restore(const standardese::parser& p, const standardese::index& idx,
+                     cache_entry& entry) const
+        {
+            p.get_logger()->debug("restoring '{}' from cache", entry.file_name);
+            standardese::parse_comments(p, entry.file_name.c_str(), entry.comments);
+
+            entry.restored.reserve(entry.entities.size());
+            for (auto& info : entry.entities)
+            {
+                auto parent = info.parent == npos() ? nullptr : entry.restored[info.parent].get();
+                entry.restored.emplace_back(new cached_entity(info, parent));
+                if (info.registered)
+                    idx.register_entity(p, *entry.restored.back(), entry.output_name,
+                                        info.anchor_id);
+            }
+        }
+
+        // creates an entry for a newly generated file, documents are added later
+        std::unique_ptr<cache_entry> create(const fs::path& path, std::string file_name,
+                                            const standardese::translation_unit& tu,
+                                            const standardese::documentation&    doc)
+        {
+            std::unique_ptr<cache_entry> result(new cache_entry);
+            result->file_name   = std::move(file_name);
+            result->output_name = static_cast<const standardese::doc_file&>(*doc.file)
+                                      .get_file_name()
+                                      .c_str();
+
+            result->dependencies.emplace_back(path.generic_string(), get_file_hash(path));
+            for (auto& dep : tu.get_file().get_dependencies())
+                result->dependencies.emplace_back(dep, get_file_hash(dep));
+            result->comments = tu.get_raw_comments();
+
+            return result;
+        }
+
+        // writes an entry, must be called after the index is complete
+        void store(const fs::path& path, cache_entry& entry, const standardese::index& idx,
+                   const standardese::documentation& doc)
+        {
+            std::unordered_map<const standardese::doc_entity*, std::size_t> indices;
+            add_entity(entry, indices, idx, *doc.file);
+
+            auto          entry_path = get_entry_path(path);
+            auto          tmp_path   = fs::path(entry_path.string() + ".tmp");
+            std::ofstream out(tmp_path.string(), std::ios_base::binary);
+            if (!out.is_open())
+                return;
+
+            boost::system::error_code ec;
+            try
+            {
+                write_entry(out, entry);
+                out.close();
+            }
+            catch (...)
+            {
+                out.close();
+                fs::remove(tmp_path, ec);
+                throw;
+            }
+
+            if (out)
+                fs::rename(tmp_path, entry_path, ec);
+            if (!out || ec)
+                fs::remove(tmp_path, ec);
+            else
+                ++stored_;
+        }
+
+        // removes least recently used entries until the cache is below its maximum size
+        void prune()
+        {
+            std::vector<std::pair<std::time_t, fs::path>> entries;
+            std::uintmax_t                                total = 0u;
+            for (fs::directory_iterator iter(dir_), end; iter != end; ++iter)
+            {
+                if (!fs::is_regular_file(iter->path())
+                    || iter->path().filename() == timings_file())
+                    continue;
+                total += fs::file_size(iter->path());
+                entries.emplace_back(fs::last_write_time(iter->path()), iter->path());
+            }
+
+            std::sort(entries.begin(), entries.end());
+            for (auto iter = entries.begin(); total > max_size_ && iter != entries.end(); ++iter)
+            {
+                total -= fs::file_size(iter->second);
+                fs::remove(iter->second);
+                ++pruned_;
+            }
+        }
+
+        // name of the file in the cache directory that stores the timings of the files,
+        // it isn't a cache entry and won't be pruned
+        static const char* timings_file() STANDARDESE_NOEXCEPT
+        {
+            return "timings";
+        }
+
+        unsigned hits() const STANDARDESE_NOEXCEPT
+        {
+            return hits_;
+        }
+
+        unsigned misses() const STANDARDESE_NOEXCEPT
+        {
+            return misses_;
+        }
+
+        unsigned stored() const STANDARDESE_NOEXCEPT
+        {
+            return stored_;
+        }
+
+        unsigned pruned() const STANDARDESE_NOEXCEPT
+        {
+            return pruned_;
+        }
+
+    private:
+        static const char* get_version() STANDARDESE_NOEXCEPT
+        {
+            return "standardese-cache-1";
+        }
+
+        fs::path get_entry_path(const fs::path& path) const
+        {
+            detail::hash h;
+            h.append(fingerprint_).append(fs::system_complete(path).generic_string());
+            return dir_ / h.str();
+        }
+
+        std::string get_file_hash(const fs::path& path)
+        {
+            auto key = path.generic_string();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto                        iter = file_hashes_.find(key);
+                if (iter != file_hashes_.end())
+                    return iter->second;
+            }
+
+            std::string content;
+            auto        result =
+                detail::read_file(path, content) ? detail::hash().append(content).str() : "";
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            file_hashes_.emplace(std::move(key), result);
+            return result;
+        }
+
+        bool is_valid(const fs::path& path, const cache_entry& entry)
+        {
+            if (entry.dependencies.empty()
+                || entry.dependencies.front().first != path.generic_string())
+                return false;
+
+            for (auto& dep : entry.dependencies)
+            {
+                auto hash = get_file_hash(dep.first);
+                if (hash.empty() || hash != dep.second)
+                    return false;
+            }
+            return true;
+        }
+
+        cached_entity_info make_info(
+            const standardese::index& idx, const standardese::doc_entity& e,
+            const std::unordered_map<const standardese::doc_entity*, std::size_t>& indices) const
+        {
+            using namespace standardese;
+
+            cached_entity_info info;
+            info.name        = e.get_name().c_str();
+            info.unique_name = e.get_unique_name().c_str();
+            for (auto i = 0; i != 4; ++i)
+                info.index_names[i] = e.get_index_name(i >= 2, i % 2 == 1).c_str();
+            info.doc_type = e.get_entity_type();
+            info.cpp_type = e.get_cpp_entity_type();
+
+            auto parent = e.has_parent() ? indices.find(&e.get_parent()) : indices.end();
+            info.parent = parent == indices.end() ? npos() : parent->second;
+
+            if (e.has_comment())
+            {
+                auto& comment = e.get_comment();
+                if (comment.in_module())
+                    info.module = comment.get_module();
+
+                auto str = cmark_render_commonmark(comment.get_content().get_brief().get_node(),
+                                                   CMARK_OPT_DEFAULT, 0);
+                info.brief = str;
+                std::free(str);
+            }
+
+            // everything but the file itself and member groups is registered
+            info.registered = e.get_entity_type() != doc_entity::file_t
+                              && e.get_entity_type() != doc_entity::member_group_t;
+            if (info.registered)
+                info.anchor_id = idx.get_linker().get_anchor_id(e);
+
+            return info;
+        }
+
+        void add_entity(cache_entry&                                                      entry,
+                        std::unordered_map<const standardese::doc_entity*, std::size_t>& indices,
+                        const standardese::index& idx, const standardese::doc_entity& e)
+        {
+            indices.emplace(&e, entry.entities.size());
+            entry.entities.push_back(make_info(idx, e, indices));
+
+            if (e.get_entity_type() == standardese::doc_entity::file_t)
+            {
+                // the file container is not visited as a child of the file
+                auto& container = static_cast<const standardese::doc_file&>(e).get_container();
+                indices.emplace(&container, entry.entities.size());
+                entry.entities.push_back(make_info(idx, container, indices));
+            }
+
+            for (auto& child : e)
+                add_entity(entry, indices, idx, child);
+        }
+
+        void write_entry(std::ostream& out, const cache_entry& entry) const
+        {
+            detail::write_string(out, get_version());
+            detail::write_string(out, entry.file_name);
+            detail::write_string(out, entry.output_name);
+
+            detail::write_number(out, entry.dependencies.size());
+            for (auto& dep : entry.dependencies)
+            {
+                detail::write_string(out, dep.first);
+                detail::write_string(out, dep.second);
+            }
+
+            detail::write_number(out, entry.comments.size());
+            for (auto& c : entry.comments)
+            {
+                detail::write_string(out, c.content);
+                detail::write_number(out, c.count_lines);
+                detail::write_number(out, c.end_line);
+            }
+
+            detail::write_number(out, entry.entities.size());
+            for (auto& e : entry.entities)
+            {
+                detail::write_string(out, e.name);
+                detail::write_string(out, e.unique_name);
+                for (auto& name : e.index_names)
+                    detail::write_string(out, name);
+                detail::write_string(out, e.brief);
+                detail::write_string(out, e.module);
+                detail::write_string(out, e.anchor_id);
+                detail::write_number(out, e.parent == npos() ? 0u : e.parent + 1u);
+                detail::write_number(out, unsigned(e.doc_type));
+                detail::write_number(out, unsigned(e.cpp_type));
+                detail::write_number(out, e.registered ? 1u : 0u);
+            }
+
+            detail::write_number(out, entry.documents.size());
+            for (auto& doc : entry.documents)
+            {
+                detail::write_string(out, doc.first);
+                detail::write_string(out, doc.second.file_name);
+                detail::write_string(out, doc.second.file_extension);
+                detail::write_string(out, doc.second.text);
+            }
+        }
+
+        std::unique_ptr<cache_entry> read_entry(const std::string& data) const
+        {
+            detail::entry_reader in(data);
+            if (in.read_string() != get_version())
+                return nullptr;
+
+            std::unique_ptr<cache_entry> result(new cache_entry);
+            result->file_name   = in.read_string();
+            result->output_name = in.read_string();
+
+            for (auto n = in.read_number(); n != 0u; --n)
+            {
+                auto path = in.read_string();
+                auto hash = in.read_string();
+                result->dependencies.emplace_back(std::move(path), std::move(hash));
+            }
+
+            for (auto n = in.read_number(); n != 0u; --n)
+            {
+                auto content     = in.read_string();
+                auto count_lines = unsigned(in.read_number());
+                auto end_line    = unsigned(in.read_number());
+                result->comments.emplace_back(std::move(content), count_lines, end_line);
+            }
+
+            for (auto n = in.read_number(); n != 0u; --n)
+            {
+                cached_entity_info info;
+                info.name        = in.read_string();
+                info.unique_name = in.read_string();
+                for (auto& name : info.index_names)
+                    name = in.read_string();
+                info.brief     = in.read_string();
+                info.module    = in.read_string();
+                info.anchor_id = in.read_string();
+
+                auto parent = in.read_number();
+                if (parent > result->entities.size())
+                    // parents are always written before their children
+                    return nullptr;
+                info.parent = parent == 0u ? npos() : std::size_t(parent - 1u);
+
+                auto doc_type = in.read_number();
+                auto cpp_type = in.read_number();
+                if (doc_type > standardese::doc_entity::member_group_t
+                    || cpp_type > standardese::cpp_entity::invalid_t)
+                    // not a valid enumerator, the entry is corrupted
+                    return nullptr;
+                info.doc_type   = standardese::doc_entity::type(doc_type);
+                info.cpp_type   = standardese::cpp_entity::type(cpp_type);
+                info.registered = in.read_number() != 0u;
+
+                result->entities.push_back(std::move(info));
+            }
+
+            for (auto n = in.read_number(); n != 0u; --n)
+            {
+                auto                      format = in.read_string();
+                standardese::raw_document doc;
+                doc.file_name      = in.read_string();
+                doc.file_extension = in.read_string();
+                doc.text           = in.read_string();
+                result->documents.emplace(std::move(format), std::move(doc));
+            }
+
+            return result;
+        }
+
+        fs::path    dir_;
+        std::string fingerprint_;
+
+        std::mutex                                   mutex_;
+        std::unordered_map<std::string, std::string> file_hashes_;
+
+        std::uintmax_t        max_size_;
+        std::atomic<unsigned> hits_, misses_, stored_, pruned_;
+    };
+} // namespace standardese_tool
+
+#endif // STANDARDESE_CACHE_HPP_INCLUDED
@@ -0,0 +1,170 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_COST_MODEL_HPP_INCLUDED
+#define STANDARDESE_COST_MODEL_HPP_INCLUDED
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+namespace standardese_tool
+{
+    namespace fs = boost::filesystem;
+
+    // estimates how long it takes to generate the documentation of a file
+    // files are estimated by their size and number of includes,
+    // files with a timing from a previous run use that timing instead
+    class cost_model
+    {
+    public:
+        // format: one line per file, "<microseconds> <path>"
+        void load(const fs::path& p)
+        {
+            std::ifstream in(p.string());
+            std::uint64_t micro;
+            std::string   path;
+            while (in >> micro && std::getline(in >> std::ws, path))
+                previous_[path] = double(micro) / 1e6;
+        }
+
+        // writes the timings of this run together with the previous timings of all other files
+        void save(const fs::path& p) const
+        {
+            auto timings = previous_;
+            for (auto& t : current_)
+                timings[t.first] = t.second;
+
+            auto          tmp_path = fs::path(p.string() + ".tmp");
+            std::ofstream out(tmp_path.string());
+            if (!out.is_open())
+                return;
+            for (auto& t : timings)
+                out << std::uint64_t(t.second * 1e6) << ' ' << t.first << '\n';
+            out.close();
+
+            boost::system::error_code ec;
+            fs::rename(tmp_path, p, ec);
+        }
+
+        // returns the estimated cost in seconds of each file
+        std::vector<double> estimate(const std::vector<fs::path>& files) const
+        {
+            // convert the heuristic into seconds by comparing it with the known timings
+            std::vector<double> heuristics;
+            heuristics.reserve(files.size());
+            auto known_heuristic = 0.0, known_seconds = 0.0;
+            for (auto& file : files)
+            {
+                heuristics.push_back(get_heuristic(file));
+
+                auto iter = previous_.find(file.generic_string());
+                if (iter != previous_.end())
+                {
+                    known_heuristic += heuristics.back();
+                    known_seconds += iter->second;
+                }
+            }
+            auto seconds_per_unit = known_heuristic > 0.0 && known_seconds > 0.0 ?
+                                        known_seconds / known_heuristic :
+                                        default_seconds_per_unit();
+
+            std::vector<double> result;
+            result.reserve(files.size());
+            for (auto i = 0u; i != files.size(); ++i)
+            {
+                auto iter = previous_.find(files[i].generic_string());
+                result.push_back(iter != previous_.end() ? iter->second :
+                                                           heuristics[i] * seconds_per_unit);
+            }
+            return result;
+        }
+
+        // records the time it took to parse the file and generate its documentation,
+        // without waiting for the memory budget
+        void record(const fs::path& file, double seconds)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            current_[file.generic_string()] = seconds;
+        }
+
+        std::size_t no_known() const
+        {
+            return previous_.size();
+        }
+
+    private:
+        // an include is weighted like this many bytes of the file itself,
+        // as it usually pulls in many other headers
+        static double include_weight()
+        {
+            return 64.0 * 1024.0;
+        }
+
+        static double default_seconds_per_unit()
+        {
+            return 1e-7;
+        }
+
+        static double get_heuristic(const fs::path& file)
+        {
+            std::ifstream in(file.string());
+            if (!in.is_open())
+                return 0.0;
+
+            auto        size = 0.0, includes = 0.0;
+            std::string line;
+            while (std::getline(in, line))
+            {
+                size += double(line.size() + 1u);
+
+                auto begin = line.find_first_not_of(" \t");
+                if (begin == std::string::npos || line[begin] != '#')
+                    continue;
+                auto directive = line.find_first_not_of(" \t", begin + 1u);
+                if (directive != std::string::npos
+                    && line.compare(directive, 7u, "include") == 0)
+                    ++includes;
+            }
+
+            return size + includes * include_weight();
+        }
+
+        std::unordered_map<std::string, double> previous_, current_;
+        std::mutex                              mutex_;
+    };
+
+    // simulates executing the jobs in the given order with the given number of threads,
+    // each job is started on the first thread that becomes idle
+    // returns the time until all jobs are finished
+    // it doesn't model the thread pool, i.e. the distribution of the jobs over the queues,
+    // the stealing or the waits for the memory budget, so the result is only an estimate
+    inline double simulate_schedule(const std::vector<double>&      durations,
+                                    const std::vector<std::size_t>& order, std::size_t no_threads)
+    {
+        std::priority_queue<double, std::vector<double>, std::greater<double>> idle_at;
+        for (auto i = 0u; i != std::max<std::size_t>(no_threads, 1u); ++i)
+            idle_at.push(0.0);
+
+        auto result = 0.0;
+        for (auto index : order)
+        {
+            auto end = idle_at.top() + durations[index];
+            idle_at.pop();
+            idle_at.push(end);
+            result = std::max(result, end);
+        }
+        return result;
+    }
+} // namespace standardese_tool
+
+#endif // STANDARDESE_COST_MODEL_HPP_INCLUDED
@@ -3,8 +3,12 @@
 // found in the top-level directory of this distribution.
 
 #include <cassert>
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
 #include <vector>
 
 #include <boost/filesystem.hpp>
@@ -21,9 +25,14 @@
 #include <standardese/parser.hpp>
 #include <standardese/template_processor.hpp>
 
+#include "cache.hpp"
+#include "cost_model.hpp"
 #include "filesystem.hpp"
+#include "memory_budget.hpp"
 #include "options.hpp"
+#include "profile.hpp"
 #include "thread_pool.hpp"
+#include "trace.hpp"
 
 namespace fs = boost::filesystem;
 namespace po = boost::program_options;
@@ -51,10 +60,15 @@ void print_usage(const char* exe_name, const po::options_description& generic,
     std::clog << configuration << '\n';
 }
 
-template <typename Generator>
+// list of source files as pairs of full and relative path
+using source_file_list = std::vector<std::pair<fs::path, fs::path>>;
+
+template <typename Generator, typename UnityGenerator>
 std::vector<standardese::documentation> generate_documentation(
-    standardese::parser& parser, const po::variables_map& map, std::size_t no_threads,
-    std::vector<standardese::template_file>& templates, Generator generate)
+    standardese::parser& parser, const po::variables_map& map, standardese_tool::thread_pool& pool,
+    standardese_tool::cost_model& costs, standardese_tool::file_cache* cache,
+    std::vector<standardese::template_file>& templates, Generator generate,
+    UnityGenerator generate_unity)
 {
     auto input              = map.at("input-files").as<std::vector<fs::path>>();
     auto source_ext         = map.at("input.source_ext").as<std::vector<std::string>>();
@@ -63,95 +77,241 @@ std::vector<standardese::documentation> generate_documentation(
     auto blacklist_dir      = map.at("input.blacklist_dir").as<std::vector<std::string>>();
     auto blacklist_dotfiles = map.at("input.blacklist_dotfiles").as<bool>();
     auto force_blacklist    = map.at("input.force_blacklist").as<bool>();
+    auto unity              = map.at("compilation.unity").as<bool>();
 
     assert(!input.empty());
     for (auto& path : input)
         parser.get_preprocessor().whitelist_include_dir(path.parent_path().generic_string());
 
-    std::vector<std::future<standardese::documentation>> futures;
-    futures.reserve(input.size());
-
+    source_file_list source_files;
+    for (auto& path : input)
+        standardese_tool::
+            handle_path(path, source_ext, blacklist_ext, blacklist_file, blacklist_dir,
+                        blacklist_dotfiles, force_blacklist,
+                        [&](bool is_source_file, const fs::path& p, const fs::path& relative) {
+                            if (is_source_file)
+                                source_files.emplace_back(p, relative);
+                            else
+                            {
+                                std::ifstream file(p.generic_string());
+                                if (!file.is_open())
+                                    parser.get_logger()
+                                        ->error("unable to open template file '{}",
+                                                p.generic_string());
+                                templates
+                                    .emplace_back(standardese_tool::get_output_name(relative)
+                                                      + relative.extension().generic_string(),
+                                                  std::
+                                                      string(std::istreambuf_iterator<char>(
+                                                                 file),
+                                                             std::istreambuf_iterator<char>{}));
+                            }
+                        });
+    if (!templates.empty() && map.at("memory-budget").as<unsigned>() != 0u)
+        // the templates keep the translation units alive, so the memory is never released
+        throw std::invalid_argument("--memory-budget can't be used with template files");
+
+    if (cache)
     {
-        standardese_tool::thread_pool pool(no_threads);
-        for (auto& path : input)
-            standardese_tool::
-                handle_path(path, source_ext, blacklist_ext, blacklist_file, blacklist_dir,
-                            blacklist_dotfiles, force_blacklist,
-                            [&](bool is_source_file, const fs::path& p, const fs::path& relative) {
-                                if (is_source_file)
-                                    futures.push_back(
-                                        standardese_tool::add_job(pool, generate, p, relative));
-                                else
-                                {
-                                    std::ifstream file(p.generic_string());
-                                    if (!file.is_open())
-                                        parser.get_logger()
-                                            ->error("unable to open template file '{}",
-                                                    p.generic_string());
-                                    templates
-                                        .emplace_back(standardese_tool::get_output_name(relative)
-                                                          + relative.extension().generic_string(),
-                                                      std::
-                                                          string(std::istreambuf_iterator<char>(
-                                                                     file),
-                                                                 std::istreambuf_iterator<char>{}));
-                                }
-                            });
+        std::vector<fs::path> paths;
+        for (auto& file : source_files)
+            paths.push_back(file.first);
+        cache->add_remote_comments(std::move(paths), parser.get_comment_config());
     }
 
     std::vector<standardese::documentation> documentations;
+    if (unity)
+    {
+        if (!source_files.empty())
+            for (auto& doc : generate_unity(source_files))
+                if (doc.file)
+                    documentations.push_back(std::move(doc));
+        return documentations;
+    }
+
+    // start the most expensive files first, so they don't determine the total time
+    std::vector<fs::path> paths;
+    paths.reserve(source_files.size());
+    for (auto& file : source_files)
+        paths.push_back(file.first);
+    auto estimated = costs.estimate(paths);
+
+    std::vector<std::size_t> order(source_files.size());
+    for (auto i = 0u; i != order.size(); ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return estimated[a] > estimated[b];
+    });
+
+    std::vector<double>      durations(source_files.size());
+    std::atomic<std::size_t> remaining(source_files.size());
+    auto                     generate_job = [&](std::size_t i) {
+        standardese_tool::detail::job_counter counter(remaining);
+
+        // the cost is only known if the file was parsed, a cache hit doesn't say anything
+        auto start  = std::chrono::steady_clock::now();
+        auto cost   = -1.0;
+        auto result = generate(source_files[i].first, source_files[i].second, cost);
+        durations[i] =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (cost >= 0.0)
+            costs.record(source_files[i].first, cost);
+
+        return result;
+    };
+
+    std::vector<std::future<standardese::documentation>> futures(source_files.size());
+    auto start = std::chrono::steady_clock::now();
+    for (auto i : order)
+        futures[i] = standardese_tool::add_job(pool, generate_job, i);
+    pool.wait_until([&] { return remaining == 0u; });
+    auto elapsed =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // keep the traversal order for the output
     for (auto& f : futures)
     {
         auto doc = f.get();
-        if (doc.document)
+        if (doc.file)
             documentations.push_back(std::move(doc));
     }
 
+    if (!source_files.empty())
+    {
+        std::vector<std::size_t> traversal_order(order.size());
+        for (auto i = 0u; i != traversal_order.size(); ++i)
+            traversal_order[i] = i;
+
+        auto longest = std::max_element(durations.begin(), durations.end()) - durations.begin();
+        auto no_threads   = pool.size();
+        auto traversal    = standardese_tool::simulate_schedule(durations, traversal_order,
+                                                             no_threads);
+        auto scheduled    = standardese_tool::simulate_schedule(durations, order, no_threads);
+        // the simulation is an idealized greedy schedule, not the work-stealing pool,
+        // so the saving is an estimate, the measured time is logged next to it
+        parser.get_logger()->info("Longest file: {} ({:.2f}s), scheduling saved an estimated "
+                                  "{:.2f}s of {:.2f}s (simulated), generation took {:.2f}s",
+                                  source_files[std::size_t(longest)].first,
+                                  durations[std::size_t(longest)], traversal - scheduled,
+                                  traversal, elapsed);
+    }
+
     return documentations;
 }
 
+// number of documented entities of a file, excluding the file itself
+std::size_t count_entities(const standardese::doc_entity& e)
+{
+    std::size_t result = 0u;
+    for (auto& child : e)
+        result += 1u + count_entities(child);
+    return result;
+}
+
+// cache entries of the generated documentations, documents are added while writing
+using pending_cache_entries =
+    std::unordered_map<const standardese::doc_entity*,
+                       std::pair<fs::path, std::unique_ptr<standardese_tool::cache_entry>>>;
+
+// documentations that were already rendered while the other files were still generated
+// or with the default template before the freeze, one raw document per output format
+using rendered_documentations =
+    std::unordered_map<const standardese::doc_entity*, std::vector<standardese::raw_document>>;
+
 void write_output_files(const standardese_tool::configuration& config,
-                        const standardese::index& idx, std::size_t no_threads,
-                        const standardese::template_file* default_template, fs::path prefix,
+                        const standardese::index& idx, standardese_tool::thread_pool& pool,
+                        fs::path prefix,
                         const std::vector<standardese::documentation>& documentations,
-                        const std::vector<standardese::raw_document>&  raw_documents)
+                        rendered_documentations&                       rendered,
+                        const std::vector<standardese::raw_document>&  raw_documents,
+                        const std::vector<std::unique_ptr<standardese_tool::cache_entry>>& cached,
+                        pending_cache_entries& pending)
 {
     using namespace standardese;
 
+    auto& log      = config.parser->get_logger();
+    auto  profiler = config.parser->get_profiler();
+    log->info("Writing files...");
+
+    auto prefix_dir = prefix.parent_path();
+    if (!prefix_dir.empty())
+        fs::create_directories(prefix_dir);
+
+    std::vector<output> outputs;
     for (auto& format : config.formats)
-    {
-        config.parser->get_logger()->info("Writing files for output format {}...",
-                                          format->extension());
-
-        auto prefix_dir = prefix.parent_path();
-        if (!prefix_dir.empty())
-            fs::create_directories(prefix_dir);
-
-        output out(*config.parser, idx, prefix.generic_string(), *format);
-        standardese_tool::for_each(no_threads, documentations,
-                                   [](const standardese::documentation& doc) {
-                                       return doc.document != nullptr;
-                                   },
-                                   [&](const standardese::documentation& doc) {
-                                       config.parser->get_logger()
-                                           ->debug("writing documentation file '{}'",
-                                                   doc.document->get_output_name());
-                                       if (default_template)
-                                           out.render_template(config.parser->get_logger(),
-                                                               *default_template, doc,
-                                                               config.link_extension());
-                                       else
-                                           out.render(config.parser->get_logger(), *doc.document,
-                                                      config.link_extension());
-                                   });
-        standardese_tool::for_each(no_threads, raw_documents,
-                                   [](const standardese::raw_document&) { return true; },
-                                   [&](const standardese::raw_document& doc) {
-                                       config.parser->get_logger()
-                                           ->debug("writing template file '{}'", doc.file_name);
-                                       out.render_raw(config.parser->get_logger(), doc);
-                                   });
-    }
+        outputs.emplace_back(*config.parser, idx, prefix.generic_string(), *format);
+
+    // all formats of a file are written by the same job
+    standardese_tool::
+        for_each(pool, documentations,
+                 [&](const standardese::documentation& doc) {
+                     return doc.document != nullptr || rendered.count(doc.file.get()) != 0u;
+                 },
+                 [&](const standardese::documentation& doc) {
+                     auto pre_rendered = rendered.find(doc.file.get());
+                     auto cache_entry  = pending.find(doc.file.get());
+                     for (auto i = 0u; i != outputs.size(); ++i)
+                     {
+                         auto& out = outputs[i];
+
+                         raw_document raw;
+                         if (pre_rendered != rendered.end())
+                             raw = std::move(pre_rendered->second[i]);
+                         else
+                         {
+                             profile_timer timer(profiler, doc.file->get_name().c_str(),
+                                                 profile_phase::render);
+                             timer.set_detail(out.get_format().extension());
+                             raw = out.get_raw(*doc.document);
+                             timer.set_bytes(raw.text.size());
+                         }
+
+                         log->debug("writing documentation file '{}'", raw.file_name);
+                         profile_timer timer(profiler, doc.file->get_name().c_str(),
+                                             profile_phase::write);
+                         timer.set_detail(out.get_format().extension());
+                         out.render_raw(log, raw, config.link_extension());
+                         timer.set_bytes(raw.text.size());
+
+                         if (cache_entry != pending.end())
+                             cache_entry->second.second->documents[out.get_format().extension()] =
+                                 std::move(raw);
+                     }
+                 });
+    standardese_tool::for_each(pool, cached,
+                               [](const std::unique_ptr<standardese_tool::cache_entry>&) {
+                                   return true;
+                               },
+                               [&](const std::unique_ptr<standardese_tool::cache_entry>& e) {
+                                   log->debug("writing cached documentation file '{}'",
+                                              e->output_name);
+                                   for (auto& out : outputs)
+                                   {
+                                       auto iter = e->documents.find(out.get_format().extension());
+                                       if (iter != e->documents.end())
+                                       {
+                                           profile_timer timer(profiler, e->file_name.c_str(),
+                                                               profile_phase::write);
+                                           timer.set_detail(out.get_format().extension());
+                                           out.render_raw(log, iter->second,
+                                                          config.link_extension());
+                                           timer.set_bytes(iter->second.text.size());
+                                       }
+                                   }
+                               });
+    standardese_tool::for_each(pool, raw_documents,
+                               [](const standardese::raw_document&) { return true; },
+                               [&](const standardese::raw_document& doc) {
+                                   log->debug("writing template file '{}'", doc.file_name);
+                                   for (auto& out : outputs)
+                                   {
+                                       profile_timer timer(profiler, doc.file_name.c_str(),
+                                                           profile_phase::write);
+                                       timer.set_detail(out.get_format().extension());
+                                       out.render_raw(log, doc);
+                                       timer.set_bytes(doc.text.size());
+                                   }
+                               });
 }
 
 int main(int argc, char* argv[])
@@ -166,6 +326,12 @@ int main(int argc, char* argv[])
              "prints more information")
             ("jobs,j", po::value<unsigned>()->default_value(standardese_tool::default_no_threads()),
              "sets the number of threads to use")
+            ("memory-budget", po::value<unsigned>()->default_value(0, "(unlimited)"),
+             "the memory in MiB the parsed files may use, fewer files are parsed in parallel to stay below it (implies --compilation.detach, can't be used with templates)")
+            ("profile", po::value<std::string>(),
+             "writes a JSON report of the time spent in each phase of each file to the given file")
+            ("trace", po::value<std::string>(),
+             "writes a trace of the phases on each thread to the given file, in the Chrome trace event format")
             ("color", po::value<bool>()->implicit_value(true)->default_value(true),
              "enable/disable color support of logger");
 
@@ -222,6 +388,14 @@ int main(int argc, char* argv[])
              "set MSVC compatibility version to fake, 0 to disable (-fms-compatibility[-version])")
             ("compilation.clang_binary", po::value<std::string>(),
              "path to clang++ binary")
+            ("compilation.preamble", po::value<std::vector<std::string>>(),
+             "adds a header that is included by most files to the preamble, it is precompiled once and reused for all files")
+            ("compilation.preprocessor", po::value<std::string>()->default_value("external"),
+             "how the files are preprocessed: external (runs the clang++ binary) or in-process (uses libclang, macros in declarations are not expanded)")
+            ("compilation.unity", po::value<bool>()->default_value(false)->implicit_value(true),
+             "parse all source files as a single translation unit, shared headers are only parsed once (implies --compilation.preprocessor=in-process)")
+            ("compilation.detach", po::value<bool>()->default_value(false)->implicit_value(true),
+             "release the translation unit of a file right after its documentation has been generated to save memory (ignored if templates are used)")
 
             ("comment.command_character", po::value<char>()->default_value('\\'),
              "character used to introduce special commands")
@@ -269,7 +443,14 @@ int main(int argc, char* argv[])
             ("output.show_group_output_section", po::value<bool>()->default_value(true)->implicit_value(true),
             "whether or not member groups have an implicit output section")
             ("output.show_modules", po::value<bool>()->default_value(true)->implicit_value(true),
-            "whether or not the module of an entity is shown in the documentation");
+            "whether or not the module of an entity is shown in the documentation")
+
+            ("cache.dir", po::value<std::string>()->default_value("", "(disabled)"),
+             "directory where the documentation of unchanged files is cached between runs")
+            ("cache.max_size", po::value<unsigned>()->default_value(256),
+             "the maximum size of the cache directory in MiB, least recently used entries are removed")
+            ("cache.timings", po::value<std::string>()->default_value("", "(<cache.dir>/timings if caching)"),
+             "file where the time needed for each file is stored, the most expensive files are started first in the next run");
     // clang-format on
 
     standardese_tool::configuration config;
@@ -309,8 +490,124 @@ int main(int argc, char* argv[])
             auto               no_threads = map.at("jobs").as<unsigned>();
             standardese::index index;
 
+            standardese_tool::profiler_list                   profilers;
+            std::unique_ptr<standardese_tool::profile_report> profile;
+            if (map.count("profile"))
+            {
+                profile.reset(new standardese_tool::profile_report);
+                profilers.add(*profile);
+            }
+            std::unique_ptr<standardese_tool::trace_recorder> trace;
+            if (map.count("trace"))
+            {
+                trace.reset(new standardese_tool::trace_recorder);
+                profilers.add(*trace);
+            }
+            if (!profilers.empty())
+                parser.set_profiler(&profilers);
+
+            std::unique_ptr<standardese_tool::file_cache> cache;
+            auto cache_dir = map.at("cache.dir").as<std::string>();
+            if (!cache_dir.empty())
+                cache.reset(new standardese_tool::file_cache(cache_dir,
+                                                             map.at("cache.max_size")
+                                                                     .as<unsigned>()
+                                                                 * std::uintmax_t(1024u * 1024u),
+                                                             config.fingerprint));
+
+            auto timings = map.at("cache.timings").as<std::string>();
+            if (timings.empty() && !cache_dir.empty())
+                timings = (fs::path(cache_dir) / standardese_tool::file_cache::timings_file())
+                              .generic_string();
+
+            standardese_tool::memory_budget budget(map.at("memory-budget").as<unsigned>()
+                                                   * std::uint64_t(1024u * 1024u));
+            std::mutex                                                budget_mutex;
+            std::vector<standardese_tool::memory_budget::reservation> parsed_memory;
+
+            standardese_tool::cost_model costs;
+            if (!timings.empty())
+                costs.load(timings);
+
+            std::mutex                                                  cache_mutex;
+            std::vector<std::unique_ptr<standardese_tool::cache_entry>> cached;
+            pending_cache_entries                                       pending;
+
+            auto prefix     = map.at("output.prefix").as<std::string>();
+            auto templ_path = map.at("template.default_template").as<std::string>();
+            std::unique_ptr<template_file> default_template;
+            if (!templ_path.empty())
+            {
+                std::ifstream file(templ_path);
+                if (!file.is_open())
+                {
+                    log->critical("unable to open template file '{}'", templ_path);
+                    return 1;
+                }
+                default_template.reset(
+                    new template_file("", std::string(std::istreambuf_iterator<char>(file),
+                                                      std::istreambuf_iterator<char>{})));
+            }
+
+            // render the documentation right after it has been generated,
+            // so only the text has to be kept until all entities are registered
+            // and the links can be resolved
+            std::mutex              rendered_mutex;
+            rendered_documentations rendered;
+            auto render = [&](standardese::documentation& doc) {
+                if (default_template || !doc.document)
+                    // templates can look up arbitrary entities
+                    return;
+
+                std::vector<raw_document> raw;
+                for (auto& format : config.formats)
+                {
+                    profile_timer timer(parser.get_profiler(), doc.file->get_name().c_str(),
+                                        profile_phase::render);
+                    timer.set_detail(format->extension());
+                    output out(parser, index, prefix, *format);
+                    raw.push_back(out.get_raw(*doc.document));
+                    timer.set_bytes(raw.back().text.size());
+                    if (!raw.back().complete)
+                        // render again once all entities are registered
+                        return;
+                }
+
+                std::lock_guard<std::mutex> lock(rendered_mutex);
+                rendered.emplace(doc.file.get(), std::move(raw));
+                doc.document.reset();
+            };
+
+            // generates the documentation of a parsed file
+            auto generate_file = [&](translation_unit& tu, std::string output_name) {
+                auto          file_name = tu.get_file().get_name();
+                profile_timer timer(parser.get_profiler(), file_name.c_str(),
+                                    profile_phase::generate);
+
+                auto result =
+                    generate_doc_file(parser, index, tu.get_file(), std::move(output_name));
+                if (profile && result.file)
+                    profile->set_counts(file_name.c_str(), count_entities(*result.file),
+                                        tu.get_raw_comments().size());
+                return result;
+            };
+
+            // the reserved memory is only released together with the translation unit
+            if (budget.limit() != 0u && default_template)
+                throw std::invalid_argument(
+                    "--memory-budget can't be used with a default template");
+
+            // the templates can use arbitrary entities, so the translation units must be kept
+            // they are all known once the files are generated, as the input is traversed first
+            std::vector<template_file> templates;
+            auto detach     = map.at("compilation.detach").as<bool>() || budget.limit() != 0u;
+            auto can_detach = [&] {
+                return detach && !default_template && templates.empty();
+            };
+
             // generate documentations
-            auto generate = [&](const fs::path& p, const fs::path& relative) {
+            // cost is set to the time spent parsing and generating, if the file was parsed
+            auto generate = [&](const fs::path& p, const fs::path& relative, double& cost) {
                 log->info("Generating documentation for {}...", p);
 
                 standardese::documentation result(nullptr, nullptr);
@@ -318,9 +615,48 @@ int main(int argc, char* argv[])
                 {
                     auto output_name = standardese_tool::get_output_name(relative);
 
-                    auto tu = parser.parse(p.generic_string().c_str(), compile_config,
-                                           relative.generic_string().c_str());
-                    result = generate_doc_file(parser, index, tu.get_file(), output_name);
+                    if (cache)
+                        if (auto entry = cache->lookup(p))
+                        {
+                            cache->restore(parser, index, *entry);
+
+                            std::lock_guard<std::mutex> lock(cache_mutex);
+                            cached.push_back(std::move(entry));
+                            return result;
+                        }
+
+                    auto reserved = budget.acquire();
+                    // measured after the wait for the memory budget
+                    auto start = std::chrono::steady_clock::now();
+                    auto tu    = parser.parse(p.generic_string().c_str(), compile_config,
+                                        relative.generic_string().c_str());
+                    reserved.finish(tu.get_memory_usage());
+
+                    result = generate_file(tu, output_name);
+                    cost   = std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+                               .count();
+
+                    if (cache && result.document)
+                    {
+                        auto entry = cache->create(p, relative.generic_string(), tu, result);
+
+                        std::lock_guard<std::mutex> lock(cache_mutex);
+                        pending.emplace(result.file.get(), std::make_pair(p, std::move(entry)));
+                    }
+                    render(result);
+
+                    if (can_detach())
+                    {
+                        detach_doc_file(result);
+                        tu.get_file().release_cxunit();
+                    }
+                    else
+                    {
+                        // the translation unit is kept alive by the parser,
+                        // so the memory stays reserved, there is no budget then
+                        std::lock_guard<std::mutex> lock(budget_mutex);
+                        parsed_memory.push_back(std::move(reserved));
+                    }
                 }
                 catch (libclang_error& ex)
                 {
@@ -334,44 +670,228 @@ int main(int argc, char* argv[])
                 return result;
             };
 
-            std::vector<template_file> templates;
-            auto                       documentations =
-                generate_documentation(parser, map, no_threads, templates, generate);
+            // generate documentations of all files from a single translation unit
+            auto generate_unity = [&](const source_file_list& source_files) {
+                source_file_list         parsed;
+                std::vector<std::string> full_paths, file_names;
+                for (auto& file : source_files)
+                {
+                    if (cache)
+                        if (auto entry = cache->lookup(file.first))
+                        {
+                            log->info("Generating documentation for {}...", file.first);
+                            cache->restore(parser, index, *entry);
+                            cached.push_back(std::move(entry));
+                            continue;
+                        }
+
+                    parsed.push_back(file);
+                    full_paths.push_back(file.first.generic_string());
+                    file_names.push_back(file.second.generic_string());
+                }
+
+                std::vector<standardese::documentation> result;
+                if (parsed.empty())
+                    return result;
+
+                log->info("Generating documentation for {} file(s) in unity mode...",
+                          parsed.size());
+                try
+                {
+                    auto tus = parser.parse_unity(full_paths, compile_config, file_names);
+
+                    // the translation unit is shared, so the files can't be processed in parallel
+                    for (auto i = 0u; i != tus.size(); ++i)
+                        try
+                        {
+                            auto output_name = standardese_tool::get_output_name(parsed[i].second);
+                            auto doc         = generate_file(tus[i], output_name);
+
+                            if (cache && doc.document)
+                            {
+                                auto entry =
+                                    cache->create(parsed[i].first, file_names[i], tus[i], doc);
+                                pending.emplace(doc.file.get(),
+                                                std::make_pair(parsed[i].first, std::move(entry)));
+                            }
+                            render(doc);
+
+                            result.push_back(std::move(doc));
+                        }
+                        catch (cmark_error& ex)
+                        {
+                            log->error("cmark error in '{}'", ex.what());
+                        }
+
+                    if (can_detach())
+                    {
+                        for (auto& doc : result)
+                            detach_doc_file(doc);
+                        for (auto& tu : tus)
+                            tu.get_file().release_cxunit();
+                    }
+                }
+                catch (libclang_error& ex)
+                {
+                    log->error("libclang error on {}", ex.what());
+                }
+
+                return result;
+            };
+
+            // a single pool is used for all phases, so the idle time shows the phase barriers
+            standardese_tool::thread_pool::idle_callback on_idle;
+            if (trace)
+                on_idle = [&](standardese_tool::thread_pool::clock::time_point begin,
+                              standardese_tool::thread_pool::clock::time_point end) {
+                    trace->record_span("idle", "idle", begin, end);
+                };
+            standardese_tool::thread_pool pool(no_threads, on_idle);
 
-            // generate indices
+            std::vector<standardese::documentation> documentations;
+            {
+                standardese_tool::trace_span span(trace.get(), "tool", "generate documentation");
+                documentations = generate_documentation(parser, map, pool, costs, cache.get(),
+                                                        templates, generate, generate_unity);
+            }
+            if (detach && !can_detach())
+                log->warn("translation units are kept alive, because templates are used");
+            if (!timings.empty())
+                costs.save(timings);
+
+            // all entities are registered now
+            index.freeze();
+
+            // generate indices, in parallel to the templates
             log->info("Generating indices...");
-            documentations.push_back(generate_file_index(index));
-            documentations.push_back(generate_entity_index(index));
-            documentations.push_back(generate_module_index(parser, index));
+            std::unique_ptr<standardese_tool::trace_span> phase_span(
+                new standardese_tool::trace_span(trace.get(), "tool", "generate indices"));
+            auto file_index = standardese_tool::add_job(pool, [&] {
+                standardese_tool::trace_span span(trace.get(), "index", "file index");
+                return generate_file_index(index);
+            });
+            auto entity_index = standardese_tool::add_job(pool, [&] {
+                standardese_tool::trace_span span(trace.get(), "index", "entity index");
+                return generate_entity_index(index);
+            });
+            auto module_index = standardese_tool::add_job(pool, [&] {
+                standardese_tool::trace_span span(trace.get(), "index", "module index");
+                return generate_module_index(parser, index);
+            });
 
             // process templates
             auto raw_documents =
-                standardese_tool::for_each(no_threads, templates,
+                standardese_tool::for_each(pool, templates,
                                            [](const template_file&) { return true; },
                                            [&](const template_file& f) {
                                                log->info("Processing template file '{}'...",
                                                          f.output_name);
+                                               profile_timer timer(parser.get_profiler(),
+                                                                   f.output_name.c_str(),
+                                                                   profile_phase::generate);
+                                               timer.set_detail("template");
                                                return process_template(parser, index, f);
                                            });
 
+            pool.wait_until([&] {
+                return standardese_tool::is_ready(file_index)
+                       && standardese_tool::is_ready(entity_index)
+                       && standardese_tool::is_ready(module_index);
+            });
+            documentations.push_back(file_index.get());
+            documentations.push_back(entity_index.get());
+            documentations.push_back(module_index.get());
+            log->info("{} of {} file(s) already rendered", rendered.size(), documentations.size());
+
+            if (default_template)
+            {
+                // processing the default template registers anchors and changes output files,
+                // so it happens before the freeze, the links are only resolved when writing
+                phase_span.reset(new standardese_tool::trace_span(trace.get(), "tool",
+                                                                  "process default template"));
+                std::vector<output> outputs;
+                for (auto& format : config.formats)
+                    outputs.emplace_back(parser, index, prefix, *format);
+
+                auto raws = standardese_tool::
+                    for_each(pool, documentations,
+                             [&](const documentation& doc) {
+                                 return doc.document != nullptr
+                                        && rendered.count(doc.file.get()) == 0u;
+                             },
+                             [&](const documentation& doc) {
+                                 std::vector<raw_document> result;
+                                 for (auto& out : outputs)
+                                 {
+                                     profile_timer timer(parser.get_profiler(),
+                                                         doc.file->get_name().c_str(),
+                                                         profile_phase::render);
+                                     timer.set_detail(out.get_format().extension());
+                                     result.push_back(out.get_raw(*default_template, doc));
+                                     timer.set_bytes(result.back().text.size());
+                                 }
+                                 return std::make_pair(doc.file.get(), std::move(result));
+                             });
+                for (auto& raw : raws)
+                    rendered.insert(std::move(raw));
+            }
+            // the templates have registered their anchors
+            index.get_linker().freeze();
+
             // write output
-            auto templ_path = map.at("template.default_template").as<std::string>();
-            auto prefix     = map.at("output.prefix").as<std::string>();
-            if (templ_path.empty())
-                write_output_files(config, index, no_threads, nullptr, prefix, documentations,
-                                   raw_documents);
-            else
+            phase_span.reset(
+                new standardese_tool::trace_span(trace.get(), "tool", "write output"));
+            write_output_files(config, index, pool, prefix, documentations, rendered,
+                               raw_documents, cached, pending);
+
+            if (cache)
             {
-                std::ifstream file(templ_path);
-                if (!file.is_open())
-                    log->critical("unable to open template file '{}'", templ_path);
-                else
+                phase_span.reset(
+                    new standardese_tool::trace_span(trace.get(), "tool", "store cache"));
+                for (auto& doc : documentations)
                 {
-                    template_file templ("", std::string(std::istreambuf_iterator<char>(file),
-                                                        std::istreambuf_iterator<char>{}));
-                    write_output_files(config, index, no_threads, &templ, prefix, documentations,
-                                       raw_documents);
+                    auto iter = doc.file ? pending.find(doc.file.get()) : pending.end();
+                    if (iter != pending.end())
+                        cache->store(iter->second.first, *iter->second.second, index, doc);
                 }
+                cache->prune();
+
+                log->info("Cache: {} hit(s), {} miss(es), {} stored, {} pruned", cache->hits(),
+                          cache->misses(), cache->stored(), cache->pruned());
+            }
+            phase_span.reset();
+
+            auto names = detail::get_name_statistics();
+            log->debug("Entity names: {} computed, {} cached", names.computed, names.cached);
+            log->debug("Tokenized {} time(s)", detail::get_tokenize_count());
+
+            if (budget.limit() != 0u)
+                log->info("Memory budget: {} of {} MiB used at most, {} file(s) had to wait",
+                          budget.peak() / (1024u * 1024u), budget.limit() / (1024u * 1024u),
+                          budget.no_throttled());
+
+            auto jobs = pool.get_statistics();
+            log->debug("Thread pool: {} thread(s), {} job(s), {} stolen, maximum queue depth {}",
+                       jobs.no_threads, jobs.jobs, jobs.steals, jobs.max_queue_depth);
+
+            parser.set_profiler(nullptr);
+            if (profile)
+            {
+                auto          profile_path = map.at("profile").as<std::string>();
+                std::ofstream file(profile_path);
+                if (!file.is_open())
+                    log->error("unable to write profile '{}'", profile_path);
+                else
+                    profile->write(file, jobs.no_threads);
+            }
+            if (trace)
+            {
+                auto          trace_path = map.at("trace").as<std::string>();
+                std::ofstream file(trace_path);
+                if (!file.is_open())
+                    log->error("unable to write trace '{}'", trace_path);
+                else
+                    trace->write(file);
             }
         }
         catch (std::exception& ex)
@@ -0,0 +1,185 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_MEMORY_BUDGET_HPP_INCLUDED
+#define STANDARDESE_MEMORY_BUDGET_HPP_INCLUDED
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace standardese_tool
+{
+    // limits the memory of the parsed files that are kept alive
+    // new files are only parsed while the estimated memory is below the budget,
+    // but at least one file is always being parsed, so the tool makes progress
+    // the memory is only bounded if the reservations are released once the memory is freed,
+    // so the tool detaches the files and rejects templates when a budget is set
+    class memory_budget
+    {
+    public:
+        // memory reserved for a file, released in the destructor
+        class reservation
+        {
+        public:
+            reservation() noexcept : budget_(nullptr), size_(0u), in_flight_(false)
+            {
+            }
+
+            reservation(reservation&& other) noexcept : budget_(other.budget_),
+                                                        size_(other.size_),
+                                                        in_flight_(other.in_flight_)
+            {
+                other.budget_ = nullptr;
+            }
+
+            ~reservation() noexcept
+            {
+                if (budget_)
+                    budget_->release(size_, in_flight_);
+            }
+
+            reservation& operator=(reservation&& other) noexcept
+            {
+                reservation tmp(std::move(other));
+                std::swap(budget_, tmp.budget_);
+                std::swap(size_, tmp.size_);
+                std::swap(in_flight_, tmp.in_flight_);
+                return *this;
+            }
+
+            // replaces the estimate by the actual size and marks the parsing as finished
+            void finish(std::uint64_t actual_size)
+            {
+                if (budget_ && in_flight_)
+                {
+                    budget_->finish(size_, actual_size);
+                    size_      = actual_size;
+                    in_flight_ = false;
+                }
+            }
+
+            std::uint64_t size() const noexcept
+            {
+                return size_;
+            }
+
+        private:
+            reservation(memory_budget& budget, std::uint64_t size) noexcept
+            : budget_(&budget),
+              size_(size),
+              in_flight_(true)
+            {
+            }
+
+            memory_budget* budget_;
+            std::uint64_t  size_;
+            bool           in_flight_;
+
+            friend memory_budget;
+        };
+
+        // a limit of zero means unlimited
+        explicit memory_budget(std::uint64_t limit) noexcept
+        : limit_(limit),
+          used_(0u),
+          peak_(0u),
+          measured_(0u),
+          no_measured_(0u),
+          no_in_flight_(0u),
+          no_throttled_(0u)
+        {
+        }
+
+        // waits until the memory for the next file is available
+        reservation acquire()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            auto                         size = estimate();
+            if (!is_available(size))
+            {
+                ++no_throttled_;
+                available_.wait(lock, [&] { return is_available(size); });
+            }
+
+            ++no_in_flight_;
+            add(size);
+            return reservation(*this, size);
+        }
+
+        std::uint64_t limit() const noexcept
+        {
+            return limit_;
+        }
+
+        std::uint64_t peak() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return peak_;
+        }
+
+        // number of files that had to wait before they could be parsed
+        std::size_t no_throttled() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return no_throttled_;
+        }
+
+    private:
+        // estimate for a file that hasn't been parsed yet, the average of the parsed files
+        std::uint64_t estimate() const noexcept
+        {
+            return no_measured_ == 0u ? default_estimate() : measured_ / no_measured_;
+        }
+
+        static std::uint64_t default_estimate() noexcept
+        {
+            return 256u * 1024u * 1024u;
+        }
+
+        bool is_available(std::uint64_t size) const noexcept
+        {
+            return limit_ == 0u || no_in_flight_ == 0u || used_ + size <= limit_;
+        }
+
+        void add(std::uint64_t size) noexcept
+        {
+            used_ += size;
+            peak_ = std::max(peak_, used_);
+        }
+
+        void finish(std::uint64_t estimate, std::uint64_t actual)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                used_ -= estimate;
+                add(actual);
+                measured_ += actual;
+                ++no_measured_;
+                --no_in_flight_;
+            }
+            available_.notify_all();
+        }
+
+        void release(std::uint64_t size, bool in_flight)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                used_ -= size;
+                if (in_flight)
+                    --no_in_flight_;
+            }
+            available_.notify_all();
+        }
+
+        mutable std::mutex      mutex_;
+        std::condition_variable available_;
+        std::uint64_t           limit_, used_, peak_;
+        std::uint64_t           measured_, no_measured_;
+        std::size_t             no_in_flight_, no_throttled_;
+    };
+} // namespace standardese_tool
+
+#endif // STANDARDESE_MEMORY_BUDGET_HPP_INCLUDED
@@ -5,6 +5,9 @@
 #ifndef STANDARDESE_OPTIONS_HPP_INCLUDED
 #define STANDARDESE_OPTIONS_HPP_INCLUDED
 
+#include <fstream>
+#include <iterator>
+
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
 #include <spdlog/spdlog.h>
@@ -33,6 +36,18 @@ namespace standardese_tool
             else
                 throw std::invalid_argument("invalid C++ standard '" + str + "'");
         }
+
+        inline standardese::preprocessor_backend parse_preprocessor(const std::string& str)
+        {
+            using namespace standardese;
+
+            if (str == "external")
+                return preprocessor_backend::external;
+            else if (str == "in-process")
+                return preprocessor_backend::in_process;
+            else
+                throw std::invalid_argument("invalid preprocessor '" + str + "'");
+        }
     } // namespace detail
 
     inline bool default_msvc_comp() noexcept
@@ -90,10 +105,18 @@ namespace standardese_tool
             result.set_msvc_compatibility_version(version);
         }
 
+        auto preamble = map.find("compilation.preamble");
+        if (preamble != map.end())
+            for (auto& val : preamble->second.as<std::vector<std::string>>())
+                result.add_preamble_header(val);
+
         auto binary = map.find("compilation.clang_binary");
         if (binary != map.end())
             result.set_clang_binary(binary->second.as<std::string>());
 
+        result.set_preprocessor_backend(
+            detail::parse_preprocessor(map.at("compilation.preprocessor").as<std::string>()));
+
         return result;
     }
 
@@ -220,6 +243,7 @@ namespace standardese_tool
         std::unique_ptr<standardese::parser>                          parser;
         standardese::compile_config                                   compile_config;
         boost::program_options::variables_map                         map;
+        std::string fingerprint; // all options that influence the generated documentation
 
         configuration() : compile_config(standardese::cpp_standard::cpp_14)
         {
@@ -254,6 +278,27 @@ namespace standardese_tool
         }
     };
 
+    namespace detail
+    {
+        inline void append_fingerprint(std::string&                                  result,
+                                       const boost::program_options::parsed_options& options)
+        {
+            for (auto& opt : options.options)
+            {
+                auto& key = opt.string_key;
+                if (key.empty() || key == "input-files" || key == "config" || key == "jobs"
+                    || key == "memory-budget" || key == "profile" || key == "trace"
+                    || key == "verbose" || key == "color" || key.compare(0, 6, "cache.") == 0)
+                    continue;
+
+                result += key;
+                for (auto& value : opt.value)
+                    result += '=' + value;
+                result += '\n';
+            }
+        }
+    } // namespace detail
+
     inline configuration get_configuration(
         int argc, char* argv[], const boost::program_options::options_description& generic,
         const boost::program_options::options_description& configuration)
@@ -299,7 +344,23 @@ namespace standardese_tool
         auto config = parse_config(map);
         auto parser = get_parser(map, cmd_result, file_result);
 
-        return {std::move(parser), std::move(config), std::move(map)};
+        std::string fingerprint = fmt::format("{}.{}\n", STANDARDESE_VERSION_MAJOR,
+                                              STANDARDESE_VERSION_MINOR);
+        detail::append_fingerprint(fingerprint, cmd_result);
+        detail::append_fingerprint(fingerprint, file_result);
+
+        auto default_template = map.at("template.default_template").as<std::string>();
+        if (!default_template.empty())
+        {
+            std::ifstream file(default_template);
+            fingerprint.append(std::istreambuf_iterator<char>(file),
+                               std::istreambuf_iterator<char>{});
+        }
+
+        standardese_tool::configuration result(std::move(parser), std::move(config),
+                                               std::move(map));
+        result.fingerprint = std::move(fingerprint);
+        return result;
     }
 } // namespace standardese_tool
 
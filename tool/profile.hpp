@@ -0,0 +1,202 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_PROFILE_HPP_INCLUDED
+#define STANDARDESE_PROFILE_HPP_INCLUDED
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <standardese/profiler.hpp>
+
+namespace standardese_tool
+{
+    namespace detail
+    {
+        inline void write_json_string(std::ostream& out, const std::string& str)
+        {
+            out << '"';
+            for (auto c : str)
+            {
+                if (c == '"' || c == '\\')
+                    out << '\\' << c;
+                else if (c == '\n')
+                    out << "\\n";
+                else if (c == '\t')
+                    out << "\\t";
+                else if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char buffer[7];
+                    std::snprintf(buffer, sizeof(buffer), "\\u%04x", unsigned(c));
+                    out << buffer;
+                }
+                else
+                    out << c;
+            }
+            out << '"';
+        }
+    } // namespace detail
+
+    // collects the time spent in each phase of each file and writes it as JSON
+    // the time spent waiting for the lock of a registry is written per registry, not per file
+    class profile_report : public standardese::profiler
+    {
+    public:
+        profile_report() : begin_(clock::now())
+        {
+        }
+
+        // sets the number of documented entities and documentation comments of a file
+        void set_counts(const std::string& file, std::size_t entities, std::size_t comments)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto&                       stats = files_[file];
+            stats.entities                    = entities;
+            stats.comments                    = comments;
+        }
+
+        void write(std::ostream& out, std::size_t no_threads) const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            file_statistics totals;
+            for (auto& file : files_)
+                totals += file.second;
+
+            out << "{\n";
+            out << "  \"wall_time\": "
+                << std::chrono::duration<double>(clock::now() - begin_).count() << ",\n";
+            out << "  \"threads\": " << no_threads << ",\n";
+            out << "  \"totals\": ";
+            write_statistics(out, totals, "  ");
+            out << ",\n  \"files\": [";
+            auto first = true;
+            for (auto& file : files_)
+            {
+                out << (first ? "\n" : ",\n") << "    {\"file\": ";
+                detail::write_json_string(out, file.first);
+                out << ", \"statistics\": ";
+                write_statistics(out, file.second, "    ");
+                out << "}";
+                first = false;
+            }
+            out << "\n  ],\n  \"lock_waits\": [";
+            first = true;
+            for (auto& lock : locks_)
+            {
+                out << (first ? "\n" : ",\n") << "    {\"lock\": ";
+                detail::write_json_string(out, lock.first);
+                out << ", ";
+                write_phase(out, lock.second);
+                out << "}";
+                first = false;
+            }
+            out << "\n  ]\n}\n";
+        }
+
+    private:
+        using clock = standardese::profile_event::clock;
+
+        struct phase_statistics
+        {
+            double      wall_time = 0.0, cpu_time = 0.0;
+            std::size_t bytes = 0u, count = 0u;
+
+            phase_statistics& operator+=(const phase_statistics& other)
+            {
+                wall_time += other.wall_time;
+                cpu_time += other.cpu_time;
+                bytes += other.bytes;
+                count += other.count;
+                return *this;
+            }
+        };
+
+        struct file_statistics
+        {
+            phase_statistics phases[std::size_t(standardese::profile_phase::count)];
+            std::size_t      entities = 0u, comments = 0u;
+
+            file_statistics& operator+=(const file_statistics& other)
+            {
+                for (auto i = 0u; i != std::size_t(standardese::profile_phase::count); ++i)
+                    phases[i] += other.phases[i];
+                entities += other.entities;
+                comments += other.comments;
+                return *this;
+            }
+        };
+
+        void do_record(const standardese::profile_event& e) override
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& phase = e.phase == standardese::profile_phase::lock_wait ?
+                              locks_[e.file] :
+                              files_[e.file].phases[std::size_t(e.phase)];
+            phase.wall_time += std::chrono::duration<double>(e.end - e.begin).count();
+            phase.cpu_time += e.cpu_time;
+            phase.bytes += e.bytes;
+            ++phase.count;
+        }
+
+        static void write_statistics(std::ostream& out, const file_statistics& stats,
+                                     const char* indent)
+        {
+            out << "{\"entities\": " << stats.entities << ", \"comments\": " << stats.comments
+                << ", \"phases\": {";
+            for (auto i = 0u; i != std::size_t(standardese::profile_phase::count); ++i)
+            {
+                if (standardese::profile_phase(i) == standardese::profile_phase::lock_wait)
+                    continue;
+                out << (i == 0u ? "\n" : ",\n") << indent << "  \""
+                    << standardese::get_phase_name(standardese::profile_phase(i)) << "\": {";
+                write_phase(out, stats.phases[i]);
+                out << "}";
+            }
+            out << "\n" << indent << "}}";
+        }
+
+        static void write_phase(std::ostream& out, const phase_statistics& phase)
+        {
+            out << "\"wall_time\": " << phase.wall_time << ", \"cpu_time\": " << phase.cpu_time
+                << ", \"bytes\": " << phase.bytes << ", \"count\": " << phase.count;
+        }
+
+        mutable std::mutex                      mutex_;
+        std::map<std::string, file_statistics>  files_; // sorted, so the output is stable
+        std::map<std::string, phase_statistics> locks_; // by the name of the registry
+        clock::time_point                       begin_;
+    };
+
+    // forwards the measured phases to multiple profilers
+    class profiler_list : public standardese::profiler
+    {
+    public:
+        void add(standardese::profiler& p)
+        {
+            profilers_.push_back(&p);
+        }
+
+        bool empty() const noexcept
+        {
+            return profilers_.empty();
+        }
+
+    private:
+        void do_record(const standardese::profile_event& e) override
+        {
+            for (auto p : profilers_)
+                p->record(e);
+        }
+
+        std::vector<standardese::profiler*> profilers_;
+    };
+} // namespace standardese_tool
+
+#endif // STANDARDESE_PROFILE_HPP_INCLUDED
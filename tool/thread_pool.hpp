@@ -5,52 +5,349 @@
 #ifndef STANDARDESE_THREAD_POOL_HPP_INCLUDED
 #define STANDARDESE_THREAD_POOL_HPP_INCLUDED
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <future>
-#include <vector>
+#include <memory>
+#include <mutex>
 #include <thread>
-
-#include <ThreadPool.h>
+#include <type_traits>
+#include <vector>
 
 namespace standardese_tool
 {
-    using thread_pool = ::ThreadPool;
-
     inline unsigned default_no_threads()
     {
         return std::max(std::thread::hardware_concurrency(), 1u);
     }
 
+    struct thread_pool_statistics
+    {
+        std::size_t no_threads;
+        std::size_t jobs;            // number of jobs executed
+        std::size_t steals;          // number of jobs a worker took from another worker's queue
+        std::size_t max_queue_depth; // maximum number of jobs waiting at the same time
+    };
+
+    // a work-stealing thread pool
+    // every worker has its own queue, jobs added from outside are distributed round-robin,
+    // jobs added by a worker are added to its own queue
+    // the jobs added from outside are taken oldest first by every thread,
+    // the callers add the most expensive ones first, so they are started first
+    // a worker takes the jobs it has added itself newest first,
+    // so a job waiting for the jobs it has added executes them before unrelated ones
+    // a worker without jobs steals the oldest job of the other queues
+    // the thread calling wait_until() executes jobs as well, taking the oldest one of any queue,
+    // so a pool of N threads has N - 1 workers
+    class thread_pool
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        // called on a thread after it had to wait, either for a new job or for a job to finish
+        using idle_callback = std::function<void(clock::time_point begin, clock::time_point end)>;
+
+        explicit thread_pool(std::size_t no_threads, idle_callback on_idle = nullptr)
+        : queues_(std::max<std::size_t>(no_threads, 2u) - 1u),
+          on_idle_(std::move(on_idle)),
+          queued_(0u),
+          next_queue_(0u),
+          jobs_(0u),
+          steals_(0u),
+          max_queue_depth_(0u),
+          stop_(false)
+        {
+            auto no_workers = std::max<std::size_t>(no_threads, 1u) - 1u;
+            workers_.reserve(no_workers);
+            for (auto i = 0u; i != no_workers; ++i)
+                workers_.emplace_back([this, i] { run(i); });
+        }
+
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        // finishes all remaining jobs
+        ~thread_pool()
+        {
+            // there may not be any worker
+            std::function<void()> job;
+            while (try_get_job(current_queue(), job))
+                execute(job);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            job_available_.notify_all();
+
+            for (auto& worker : workers_)
+                worker.join();
+        }
+
+        template <typename Fnc, typename... Args>
+        auto add_job(Fnc f, Args&&... args)
+            -> std::future<typename std::result_of<Fnc(Args...)>::type>
+        {
+            using result_type = typename std::result_of<Fnc(Args...)>::type;
+
+            auto task = std::make_shared<std::packaged_task<result_type()>>(
+                std::bind(std::move(f), std::forward<Args>(args)...));
+            auto result = task->get_future();
+            push([task] { (*task)(); });
+            return result;
+        }
+
+        // executes jobs on the calling thread until the predicate returns true,
+        // so it can also be called from inside a job without blocking a worker
+        template <typename Predicate>
+        void wait_until(const Predicate& p)
+        {
+            while (!p())
+            {
+                std::function<void()> job;
+                if (try_get_job(current_queue(), job))
+                    execute(job);
+                else
+                {
+                    auto begin = on_idle_ ? clock::now() : clock::time_point();
+                    {
+                        std::unique_lock<std::mutex> lock(mutex_);
+                        job_finished_.wait(lock, [&] { return p() || queued_ != 0u; });
+                    }
+                    if (on_idle_)
+                        on_idle_(begin, clock::now());
+                }
+            }
+        }
+
+        // the number of threads executing jobs, including the one waiting
+        std::size_t size() const noexcept
+        {
+            return workers_.size() + 1u;
+        }
+
+        thread_pool_statistics get_statistics() const noexcept
+        {
+            return {size(), jobs_, steals_, max_queue_depth_};
+        }
+
+    private:
+        struct queue
+        {
+            std::mutex                        mutex;
+            std::deque<std::function<void()>> jobs;  // added from outside
+            std::deque<std::function<void()>> local; // added by the worker itself
+        };
+
+        struct worker_info
+        {
+            const thread_pool* pool;
+            std::size_t        index;
+        };
+
+        static worker_info& current_worker()
+        {
+            static thread_local worker_info info = {nullptr, 0u};
+            return info;
+        }
+
+        // index of the queue of the calling thread, or the number of queues if it isn't a worker
+        std::size_t current_queue() const
+        {
+            auto& info = current_worker();
+            return info.pool == this ? info.index : queues_.size();
+        }
+
+        void push(std::function<void()> job)
+        {
+            auto index    = current_queue();
+            auto is_local = index != queues_.size();
+            if (!is_local)
+                index = next_queue_++ % queues_.size();
+
+            std::size_t depth;
+            {
+                std::lock_guard<std::mutex> lock(queues_[index].mutex);
+                (is_local ? queues_[index].local : queues_[index].jobs).push_back(std::move(job));
+                // counted while the queue is locked, so before any thread can take the job
+                depth = ++queued_;
+            }
+
+            {
+                // a thread that has just seen no job is waiting once the lock is acquired
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (depth > max_queue_depth_)
+                    max_queue_depth_ = depth;
+            }
+            job_available_.notify_one();
+        }
+
+        // takes the newest job the worker has added itself or the oldest one of its queue,
+        // otherwise it steals the oldest job of another queue,
+        // a thread that isn't a worker takes the oldest job of any queue
+        bool try_get_job(std::size_t index, std::function<void()>& job)
+        {
+            if (index != queues_.size())
+            {
+                std::lock_guard<std::mutex> lock(queues_[index].mutex);
+                auto&                       own = queues_[index];
+                if (!own.local.empty())
+                {
+                    job = std::move(own.local.back());
+                    own.local.pop_back();
+                    --queued_;
+                    return true;
+                }
+                else if (!own.jobs.empty())
+                {
+                    job = std::move(own.jobs.front());
+                    own.jobs.pop_front();
+                    --queued_;
+                    return true;
+                }
+            }
+
+            auto start = index == queues_.size() ? 0u : index + 1u;
+            for (auto i = 0u; i != queues_.size(); ++i)
+            {
+                auto& victim = queues_[(start + i) % queues_.size()];
+
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                auto& jobs = victim.jobs.empty() ? victim.local : victim.jobs;
+                if (jobs.empty())
+                    continue;
+
+                job = std::move(jobs.front());
+                jobs.pop_front();
+                if (index != queues_.size())
+                    ++steals_;
+                --queued_;
+                return true;
+            }
+
+            return false;
+        }
+
+        void execute(std::function<void()>& job)
+        {
+            job();
+            ++jobs_;
+
+            // notify threads waiting for a job to finish
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_finished_.notify_all();
+        }
+
+        void run(std::size_t index)
+        {
+            current_worker() = {this, index};
+
+            while (true)
+            {
+                std::function<void()> job;
+                if (try_get_job(index, job))
+                    execute(job);
+                else
+                {
+                    auto begin = on_idle_ ? clock::now() : clock::time_point();
+                    {
+                        std::unique_lock<std::mutex> lock(mutex_);
+                        job_available_.wait(lock, [&] { return stop_ || queued_ != 0u; });
+                        if (stop_ && queued_ == 0u)
+                            break;
+                    }
+                    if (on_idle_)
+                        on_idle_(begin, clock::now());
+                }
+            }
+        }
+
+        std::vector<queue>       queues_;
+        std::vector<std::thread> workers_;
+        idle_callback            on_idle_;
+
+        std::mutex               mutex_;
+        std::condition_variable  job_available_, job_finished_;
+        std::atomic<std::size_t> queued_, next_queue_;
+        std::atomic<std::size_t> jobs_, steals_, max_queue_depth_;
+        bool                     stop_; // protected by mutex_
+    };
+
     template <typename Fnc, typename... Args>
     auto add_job(thread_pool& p, Fnc f, Args&&... args)
         -> std::future<typename std::result_of<Fnc(Args...)>::type>
     {
-        return p.enqueue(f, std::forward<Args>(args)...);
+        return p.add_job(std::move(f), std::forward<Args>(args)...);
     }
 
+    template <typename T>
+    bool is_ready(const std::future<T>& f)
+    {
+        return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    namespace detail
+    {
+        // decrements the counter once the job is done, even if it throws
+        class job_counter
+        {
+        public:
+            explicit job_counter(std::atomic<std::size_t>& counter) noexcept : counter_(&counter)
+            {
+            }
+
+            ~job_counter() noexcept
+            {
+                --*counter_;
+            }
+
+        private:
+            std::atomic<std::size_t>* counter_;
+        };
+    } // namespace detail
+
     template <typename Container, typename Predicate, typename Func>
-    auto for_each(std::size_t no_threads, const Container& cont, const Predicate& p, const Func& f)
+    auto for_each(thread_pool& pool, const Container& cont, const Predicate& p, const Func& f)
         -> typename std::enable_if<std::is_same<decltype(f(cont[0])), void>::value>::type
     {
-        thread_pool pool(no_threads);
+        std::atomic<std::size_t> remaining(0u);
         for (auto& elem : cont)
             if (p(elem))
-                add_job(pool, f, std::ref(elem));
+            {
+                ++remaining;
+                add_job(pool, [&](decltype(elem) e) {
+                    detail::job_counter counter(remaining);
+                    f(e);
+                }, std::ref(elem));
+            }
+
+        pool.wait_until([&] { return remaining == 0u; });
     }
 
     template <typename Container, typename Predicate, typename Func>
-    auto for_each(std::size_t no_threads, const Container& cont, const Predicate& p, const Func& f)
+    auto for_each(thread_pool& pool, const Container& cont, const Predicate& p, const Func& f)
         -> typename std::enable_if<!std::is_same<decltype(f(cont[0])), void>::value,
                                    std::vector<decltype(f(cont[0]))>>::type
     {
         std::vector<std::future<decltype(f(cont[0]))>> futures;
         futures.reserve(cont.size());
 
-        {
-            thread_pool pool(no_threads);
-            for (auto& elem : cont)
-                if (p(elem))
-                    futures.push_back(add_job(pool, f, std::ref(elem)));
-        }
+        std::atomic<std::size_t> remaining(0u);
+        for (auto& elem : cont)
+            if (p(elem))
+            {
+                ++remaining;
+                futures.push_back(add_job(pool, [&](decltype(elem) e) {
+                    detail::job_counter counter(remaining);
+                    return f(e);
+                }, std::ref(elem)));
+            }
+
+        pool.wait_until([&] { return remaining == 0u; });
 
         std::vector<decltype(f(cont[0]))> results;
         results.reserve(futures.size());
@@ -0,0 +1,176 @@
+// Copyright (C) 2016-2017 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_TRACE_HPP_INCLUDED
+#define STANDARDESE_TRACE_HPP_INCLUDED
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <standardese/profiler.hpp>
+
+#include "profile.hpp"
+
+namespace standardese_tool
+{
+    // records the phases of the files as spans on the thread that executed them
+    // and writes them in the Chrome trace event format,
+    // which can be viewed in chrome://tracing or https://ui.perfetto.dev
+    class trace_recorder : public standardese::profiler
+    {
+    public:
+        using clock = standardese::profile_event::clock;
+
+        // the thread that creates the recorder is the main thread
+        trace_recorder() : begin_(clock::now())
+        {
+            thread_ids_.emplace(std::this_thread::get_id(), 0u);
+        }
+
+        // records a span that isn't the phase of a file, e.g. a phase of the tool
+        void record_span(const char* category, std::string name, clock::time_point begin,
+                         clock::time_point end)
+        {
+            span s;
+            s.category = category;
+            s.name     = std::move(name);
+            s.begin    = begin;
+            s.end      = end;
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            s.thread = get_thread_id();
+            spans_.push_back(std::move(s));
+        }
+
+        void write(std::ostream& out) const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+            for (auto i = 0u; i != thread_ids_.size(); ++i)
+            {
+                out << (i == 0u ? "\n" : ",\n")
+                    << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << i
+                    << ", \"args\": {\"name\": \"";
+                if (i == 0u)
+                    out << "main";
+                else
+                    out << "thread " << i;
+                out << "\"}}";
+            }
+            // there is always the main thread, so the spans follow a metadata event
+            for (auto& s : spans_)
+            {
+                out << ",\n{\"name\": ";
+                detail::write_json_string(out, s.name);
+                out << ", \"cat\": \"" << s.category << "\", \"ph\": \"X\", \"ts\": "
+                    << to_microseconds(s.begin - begin_)
+                    << ", \"dur\": " << to_microseconds(s.end - s.begin)
+                    << ", \"pid\": 1, \"tid\": " << s.thread;
+                if (!s.file.empty())
+                {
+                    out << ", \"args\": {\"file\": ";
+                    detail::write_json_string(out, s.file);
+                    if (!s.detail.empty())
+                    {
+                        out << ", \"detail\": ";
+                        detail::write_json_string(out, s.detail);
+                    }
+                    out << ", \"bytes\": " << s.bytes << ", \"cpu_time\": " << s.cpu_time << "}";
+                }
+                out << "}";
+            }
+            out << "\n]}\n";
+        }
+
+    private:
+        struct span
+        {
+            const char*       category;
+            std::string       name, file, detail;
+            clock::time_point begin, end;
+            std::size_t       thread, bytes = 0u;
+            double            cpu_time      = 0.0;
+        };
+
+        void do_record(const standardese::profile_event& e) override
+        {
+            span s;
+            s.category = standardese::get_phase_name(e.phase);
+            s.name     = std::string(s.category) + ' ' + e.file;
+            if (!e.detail.empty())
+                s.name += " (" + e.detail + ')';
+            s.file     = e.file;
+            s.detail   = e.detail;
+            s.begin    = e.begin;
+            s.end      = e.end;
+            s.bytes    = e.bytes;
+            s.cpu_time = e.cpu_time;
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            s.thread = get_thread_id();
+            spans_.push_back(std::move(s));
+        }
+
+        // small, consecutive ids in the order the threads are first seen
+        std::size_t get_thread_id()
+        {
+            auto id = thread_ids_.size();
+            return thread_ids_.emplace(std::this_thread::get_id(), id).first->second;
+        }
+
+        static long long to_microseconds(clock::duration d)
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+        }
+
+        mutable std::mutex                     mutex_;
+        std::vector<span>                      spans_;
+        std::map<std::thread::id, std::size_t> thread_ids_;
+        clock::time_point                      begin_;
+    };
+
+    // records a span from its construction to its destruction, if there is a recorder
+    class trace_span
+    {
+    public:
+        trace_span(trace_recorder* recorder, const char* category, const char* name)
+        : recorder_(recorder), category_(category), name_(name)
+        {
+            if (recorder_)
+                begin_ = trace_recorder::clock::now();
+        }
+
+        trace_span(const trace_span&) = delete;
+        trace_span& operator=(const trace_span&) = delete;
+
+        ~trace_span() noexcept
+        {
+            if (!recorder_)
+                return;
+
+            try
+            {
+                recorder_->record_span(category_, name_, begin_, trace_recorder::clock::now());
+            }
+            catch (...)
+            {
+                // tracing must not influence the result
+            }
+        }
+
+    private:
+        trace_recorder*                   recorder_;
+        const char*                       category_;
+        const char*                       name_;
+        trace_recorder::clock::time_point begin_;
+    };
+} // namespace standardese_tool
+
+#endif // STANDARDESE_TRACE_HPP_INCLUDED